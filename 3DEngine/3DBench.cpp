@@ -0,0 +1,319 @@
+// Scene benchmark for olcEngine3D
+//
+// Runs the engine headless over each OBJ asset, screen size and scripted
+// camera path, feeding it a fixed fElapsedTime and scripted key presses so
+// every run renders exactly the same frames. Results go out as JSON so runs
+// can be compared by a tool rather than by eyeballing the title bar FPS.
+// Built with OLC_PROFILE, each run also gets per-stage p50/p95/p99 and any
+// frame over --budget milliseconds is dumped stage by stage to stderr, and
+// built with OLC_COUNT_ALLOCS it gets the heap allocations per frame.
+//
+//   3DBench [--frames N] [--warmup N] [--step seconds] [--out file.json]
+//           [--mesh file.obj]... [--res WxH]... [--path name]... [--budget ms]
+//           [--no-cache] [--kernel avx512|avx2|sse2|scalar] [--depth]
+//           [--tiled] [--parallel-geometry] [--threads N] [--no-guard-band]
+//           [--no-culling] [--terrain-lod] [--lod-error cells]
+//           [--terminal] [--terminal-repeat] [--half-space] [--dither]
+
+#include "olcEngine3D.h"
+
+struct sPathSegment {
+    std::vector<int> vecKeys;   // keys held for the whole segment
+    int nFrames;
+};
+
+struct sCameraPath {
+    std::string sName;
+    std::vector<sPathSegment> vecSegments;  // repeated until the run ends
+};
+
+static const std::vector<sCameraPath> vecCameraPaths = {
+    { "static",     { { {}, 1 } } },
+    { "orbit",      { { { L'D' }, 1 } } },
+    { "flythrough", { { { L'W' }, 120 }, { { L'W', L'A' }, 30 }, { { L'W' }, 120 }, { { L'S', L'D' }, 30 } } },
+    { "crane",      { { { VK_UP }, 90 }, { { VK_LEFT }, 90 }, { { VK_DOWN }, 90 }, { { VK_RIGHT }, 90 } } },
+};
+
+class olcBench3D : public olcEngine3D {
+public:
+    olcBench3D(const std::string& sMesh, bool bMeshCache, const sCameraPath& path, float fStep, int nWarmup)
+        : olcEngine3D(sMesh, bMeshCache), cameraPath(path), fTimeStep(fStep), nWarmupFrames(nWarmup) {}
+
+    std::vector<float> vecFrameMs;
+    long long nTrianglesTotal = 0;
+    long long nClippedTotal = 0;
+    long long nInViewTotal = 0;
+    long long nTransformedTotal = 0;
+    long long nShadedTotal = 0;
+    long long nCellsTotal = 0;
+    long long nAllocsTotal = 0;
+    long long nPresentCellsTotal = 0;
+    long long nPresentBytesTotal = 0;
+    long long nPresentWritesTotal = 0;
+    int nPresentFrames = 0;
+    int nCoherentSorts = 0;
+
+private:
+    const sCameraPath& cameraPath;
+    float fTimeStep;
+    int nWarmupFrames;
+    int nFrame = 0;
+    size_t nSegment = 0;
+    int nSegmentFrame = 0;
+
+    // The engine presents a frame after OnUserUpdate returns, so what each
+    // measured frame sent to the console is only known at the next update,
+    // or for the last one once the engine is shutting down
+    void CountPresent() {
+        if (nFrame > nWarmupFrames) {
+            nPresentCellsTotal += PresentStats().nCells;
+            nPresentBytesTotal += (long long)PresentStats().nBytes;
+            nPresentWritesTotal += PresentStats().nWrites;
+            nPresentFrames++;
+        }
+    }
+
+public:
+    bool OnUserDestroy() override {
+        CountPresent();
+        return olcEngine3D::OnUserDestroy();
+    }
+
+    bool OnUserUpdate(float /*fElapsedTime*/) override {
+        CountPresent();
+
+        // Stand in for the keyboard: hold exactly the keys of the current segment
+        for (auto& k : m_keys)
+            k.bHeld = false;
+        for (int k : cameraPath.vecSegments[nSegment].vecKeys)
+            m_keys[k].bHeld = true;
+
+        // ...and for the clock, so every run sees the same camera positions
+        uint64_t nCellsBefore = CellsFilled();
+        auto tp1 = std::chrono::steady_clock::now();
+        bool bResult = olcEngine3D::OnUserUpdate(fTimeStep);
+        auto tp2 = std::chrono::steady_clock::now();
+
+        if (nFrame++ >= nWarmupFrames) {
+            vecFrameMs.push_back(std::chrono::duration<float, std::milli>(tp2 - tp1).count());
+            nTrianglesTotal += TrianglesDrawn();
+            nClippedTotal += TrianglesClipped();
+            nInViewTotal += TrianglesInView();
+            nTransformedTotal += (long long)VerticesTransformed();
+            nShadedTotal += (long long)TrianglesShaded();
+            nCellsTotal += (long long)(CellsFilled() - nCellsBefore);
+            nCoherentSorts += SortWasCoherent() ? 1 : 0;
+#ifdef OLC_COUNT_ALLOCS
+            nAllocsTotal += (long long)FrameAllocations();
+#endif
+        }
+
+        if (++nSegmentFrame >= cameraPath.vecSegments[nSegment].nFrames) {
+            nSegmentFrame = 0;
+            nSegment = (nSegment + 1) % cameraPath.vecSegments.size();
+        }
+        return bResult;
+    }
+};
+
+static float Percentile(const std::vector<float>& vecSorted, float p)
+{
+    size_t i = (size_t)(p * (float)(vecSorted.size() - 1) + 0.5f);
+    return vecSorted[std::min(i, vecSorted.size() - 1)];
+}
+
+static double PerFrame(long long nTotal, int nFrames)
+{
+    return nFrames > 0 ? (double)nTotal / nFrames : 0.0;
+}
+
+int main(int argc, char* argv[])
+{
+    int nFrames = 300;
+    int nWarmup = 30;
+    float fStep = 1.0f / 60.0f;
+    float fBudgetMs = 0.0f;
+    bool bMeshCache = true;
+    bool bDepthBuffer = false;
+    bool bTiledRaster = false;
+    bool bParallelGeometry = false;
+    bool bGuardBand = true;
+    bool bFrustumCulling = true;
+    bool bTerrainLod = false;
+    float fLodError = 1.0f;
+    bool bTerminal = false;
+    bool bTerminalRepeat = false;
+    bool bHalfSpace = false;
+    bool bDither = false;
+    int nThreads = 0;
+    std::string sOutFile;
+    std::vector<std::string> vecMeshes;
+    std::vector<std::pair<int, int>> vecResolutions;
+    std::vector<std::string> vecPathNames;
+
+    for (int a = 1; a < argc; a++) {
+        std::string arg = argv[a];
+        bool bHasValue = a + 1 < argc;
+        if (arg == "--frames" && bHasValue) nFrames = atoi(argv[++a]);
+        else if (arg == "--warmup" && bHasValue) nWarmup = atoi(argv[++a]);
+        else if (arg == "--step" && bHasValue) fStep = (float)atof(argv[++a]);
+        else if (arg == "--out" && bHasValue) sOutFile = argv[++a];
+        else if (arg == "--budget" && bHasValue) fBudgetMs = (float)atof(argv[++a]);
+        else if (arg == "--no-cache") bMeshCache = false;
+        else if (arg == "--depth") bDepthBuffer = true;
+        else if (arg == "--tiled") bTiledRaster = true;
+        else if (arg == "--parallel-geometry") bParallelGeometry = true;
+        else if (arg == "--threads" && bHasValue) nThreads = atoi(argv[++a]);
+        else if (arg == "--no-guard-band") bGuardBand = false;
+        else if (arg == "--no-culling") bFrustumCulling = false;
+        else if (arg == "--terrain-lod") bTerrainLod = true;
+        else if (arg == "--lod-error" && bHasValue) fLodError = (float)atof(argv[++a]);
+        else if (arg == "--terminal") bTerminal = true;
+        else if (arg == "--half-space") bHalfSpace = true;
+        else if (arg == "--dither") bDither = true;
+        else if (arg == "--terminal-repeat") bTerminal = bTerminalRepeat = true;
+        else if (arg == "--kernel" && bHasValue) {
+            if (!Transform_SetKernel(argv[++a])) {
+                fprintf(stderr, "ERROR: transform kernel %s isn't available on this CPU\n", argv[a]);
+                return 1;
+            }
+        }
+        else if (arg == "--mesh" && bHasValue) vecMeshes.push_back(argv[++a]);
+        else if (arg == "--path" && bHasValue) vecPathNames.push_back(argv[++a]);
+        else if (arg == "--res" && bHasValue) {
+            int w = 0, h = 0;
+            if (sscanf(argv[++a], "%dx%d", &w, &h) == 2 && w > 0 && h > 0)
+                vecResolutions.push_back({ w, h });
+        }
+        else {
+            fprintf(stderr, "usage: 3DBench [--frames N] [--warmup N] [--step seconds] [--out file.json]\n"
+                            "               [--mesh file.obj]... [--res WxH]... [--path name]... [--budget ms]\n"
+                            "               [--no-cache] [--kernel avx512|avx2|sse2|scalar] [--depth]\n"
+                            "               [--tiled] [--parallel-geometry] [--threads N] [--no-guard-band]\n"
+                            "               [--no-culling] [--terrain-lod] [--lod-error cells]\n"
+                            "               [--terminal] [--terminal-repeat] [--half-space] [--dither]\n");
+            return 1;
+        }
+    }
+
+#ifndef OLC_PROFILE
+    if (fBudgetMs > 0.0f)
+        fprintf(stderr, "warning: --budget needs a build with OLC_PROFILE defined\n");
+#endif
+
+    if (vecMeshes.empty())
+        vecMeshes = { "mountains.obj", "teapot.obj", "ship.obj", "VideoShip.obj", "axis.obj" };
+    if (vecResolutions.empty())
+        vecResolutions = { { 256, 240 }, { 512, 480 }, { 1024, 960 } };
+    if (vecPathNames.empty())
+        for (auto& path : vecCameraPaths)
+            vecPathNames.push_back(path.sName);
+
+    FILE* out = stdout;
+    if (!sOutFile.empty() && (out = fopen(sOutFile.c_str(), "w")) == nullptr) {
+        fprintf(stderr, "ERROR: can't write %s\n", sOutFile.c_str());
+        return 1;
+    }
+
+    if (nThreads <= 0)
+        nThreads = std::max(1, (int)std::thread::hardware_concurrency());
+
+    fprintf(out, "{\n  \"frames\": %d,\n  \"warmup\": %d,\n  \"step\": %g,\n  \"transform_kernel\": \"%s\",\n  \"depth_buffer\": %s,\n"
+                 "  \"tiled_raster\": %s,\n  \"parallel_geometry\": %s,\n  \"threads\": %d,\n  \"guard_band\": %s,\n  \"frustum_culling\": %s,\n"
+                 "  \"terrain_lod\": %s,\n  \"lod_error\": %g,\n  \"terminal_output\": %s,\n  \"terminal_repeat\": %s,\n  \"half_space_raster\": %s,\n  \"dither\": %s,\n  \"runs\": [",
+        nFrames, nWarmup, fStep, Transform_KernelName(), bDepthBuffer ? "true" : "false",
+        bTiledRaster ? "true" : "false", bParallelGeometry ? "true" : "false", bTiledRaster || bParallelGeometry ? nThreads : 1,
+        bGuardBand ? "true" : "false", bFrustumCulling ? "true" : "false", bTerrainLod ? "true" : "false", fLodError,
+        bTerminal ? "true" : "false", bTerminalRepeat ? "true" : "false", bHalfSpace ? "true" : "false", bDither ? "true" : "false");
+
+    bool bFirst = true;
+    int nFailed = 0;
+    for (auto& sMesh : vecMeshes) {
+        for (auto& res : vecResolutions) {
+            for (auto& sPath : vecPathNames) {
+                auto path = std::find_if(vecCameraPaths.begin(), vecCameraPaths.end(), [&](const sCameraPath& p) { return p.sName == sPath; });
+                if (path == vecCameraPaths.end()) {
+                    fprintf(stderr, "ERROR: unknown camera path %s\n", sPath.c_str());
+                    nFailed++;
+                    continue;
+                }
+
+                olcBench3D bench(sMesh, bMeshCache, *path, fStep, nWarmup);
+                bench.SetDepthBuffer(bDepthBuffer);
+                bench.SetThreads(nThreads);
+                bench.SetTiledRaster(bTiledRaster);
+                bench.SetParallelGeometry(bParallelGeometry);
+                bench.SetGuardBand(bGuardBand);
+                bench.SetFrustumCulling(bFrustumCulling);
+                bench.SetTerrainLod(bTerrainLod);
+                bench.SetLodError(fLodError);
+                bench.SetTerminalOutput(bTerminal);
+                bench.SetTerminalRepeat(bTerminalRepeat);
+                bench.SetHalfSpaceRaster(bHalfSpace);
+                bench.SetDither(bDither);
+                bench.SetCountCellsFilled(true);
+#ifdef OLC_PROFILE
+                bench.Profiler().fBudgetMs = fBudgetMs;
+#endif
+                if (bench.ConstructHeadless(res.first, res.second, nWarmup + nFrames))
+                    bench.Start();
+
+                if (bench.vecFrameMs.empty()) {
+                    fprintf(stderr, "ERROR: %s failed to render\n", sMesh.c_str());
+                    nFailed++;
+                    continue;
+                }
+
+                std::vector<float> vecSorted = bench.vecFrameMs;
+                std::sort(vecSorted.begin(), vecSorted.end());
+                double dTotalMs = 0.0;
+                for (float ms : vecSorted)
+                    dTotalMs += ms;
+                double dSeconds = dTotalMs / 1000.0;
+                double dFps = (double)vecSorted.size() / dSeconds;
+                double dTrisPerSec = (double)bench.nTrianglesTotal / dSeconds;
+                double dCellsPerSec = (double)bench.nCellsTotal / dSeconds;
+
+                fprintf(out, "%s\n    { \"mesh\": \"%s\", \"width\": %d, \"height\": %d, \"path\": \"%s\", \"mesh_triangles\": %zu, "
+                             "\"load_ms\": %.3f, \"load_mb_per_sec\": %.1f, \"load_from_cache\": %s, "
+                             "\"fps\": %.2f, \"ms_mean\": %.4f, \"ms_p50\": %.4f, \"ms_p95\": %.4f, \"ms_p99\": %.4f, \"ms_max\": %.4f, "
+                             "\"triangles_in_view_per_frame\": %.1f, \"triangles_per_frame\": %.1f, \"triangles_clipped_per_frame\": %.1f, \"triangles_per_sec\": %.0f, "
+                             "\"coherent_sort_frames\": %.3f, \"vertices_transformed_per_frame\": %.1f, \"shaded_triangles_per_frame\": %.1f, "
+                             "\"present_cells_per_frame\": %.1f, \"present_bytes_per_frame\": %.1f, \"present_writes_per_frame\": %.2f, "
+                             "\"cells_filled_per_frame\": %.1f, \"cells_filled_per_sec\": %.0f",
+                    bFirst ? "" : ",", sMesh.c_str(), res.first, res.second, sPath.c_str(), bench.MeshTriangles(),
+                    bench.MeshLoadStats().fSeconds * 1000.0f, bench.MeshLoadStats().MBPerSecond(), bench.MeshFromCache() ? "true" : "false",
+                    dFps, dTotalMs / vecSorted.size(), Percentile(vecSorted, 0.50f), Percentile(vecSorted, 0.95f),
+                    Percentile(vecSorted, 0.99f), vecSorted.back(),
+                    (double)bench.nInViewTotal / vecSorted.size(), (double)bench.nTrianglesTotal / vecSorted.size(), (double)bench.nClippedTotal / vecSorted.size(), dTrisPerSec,
+                    (double)bench.nCoherentSorts / vecSorted.size(), (double)bench.nTransformedTotal / vecSorted.size(), (double)bench.nShadedTotal / vecSorted.size(),
+                    PerFrame(bench.nPresentCellsTotal, bench.nPresentFrames), PerFrame(bench.nPresentBytesTotal, bench.nPresentFrames),
+                    PerFrame(bench.nPresentWritesTotal, bench.nPresentFrames),
+                    (double)bench.nCellsTotal / vecSorted.size(), dCellsPerSec);
+#ifdef OLC_COUNT_ALLOCS
+                fprintf(out, ", \"allocs_per_frame\": %.2f", (double)bench.nAllocsTotal / vecSorted.size());
+#endif
+#ifdef OLC_PROFILE
+                PipelineProfiler::Stats stats = bench.Profiler().GetStats();
+                fprintf(out, ", \"stages\": {");
+                for (int s = 0; s < STAGE_COUNT; s++)
+                    fprintf(out, "%s \"%s\": { \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f }", s ? "," : "",
+                        PipelineStageName(s), stats.stage[s].p50, stats.stage[s].p95, stats.stage[s].p99);
+                fprintf(out, " }");
+#endif
+                fprintf(out, " }");
+                bFirst = false;
+
+                fprintf(stderr, "%-14s %4dx%-4d %-10s %9.1f fps  p50 %7.3f ms  p99 %7.3f ms  %12.0f tris/s\n",
+                    sMesh.c_str(), res.first, res.second, sPath.c_str(), dFps,
+                    Percentile(vecSorted, 0.50f), Percentile(vecSorted, 0.99f), dTrisPerSec);
+            }
+        }
+    }
+
+    fprintf(out, "\n  ]\n}\n");
+    if (out != stdout)
+        fclose(out);
+
+    return nFailed > 0 ? 1 : 0;
+}
@@ -1,624 +1,77 @@
-#include "olcConsoleGameEngine.h"
-#include <fstream>
-#include <strstream>
-#include <algorithm>
+#include "olcEngine3D.h"
 
-struct Vec3d {
-    float 
-        x = 0,
-        y = 0,
-        z = 0,
-        w = 1;
-};
-
-struct Triangle {
-    Vec3d p[3];
-    wchar_t sym;
-    short col;
-};
-
-struct Mesh {
-    std::vector<Triangle> tris;
-    
-    bool loadFromObjectFile(std::string sFileName) {
-        std::ifstream f(sFileName);
-        if (!f.is_open())
-            return false;
-           
-        //local cache of verts
-        std::vector<Vec3d> verts;
-
-        while (!f.eof()) {
-            char line[128];
-            f.getline(line, 128);
-            Vec3d v;
-            char junk;
-
-            std::strstream s;
-            s << line;
-
-            if (line[0] == 'v') {
-                s >> junk >> v.x >> v.y >> v.z;
-                verts.push_back(v);
-            }
-
-            if(line[0]=='f'){
-                int f[3];
-                s >> junk >> f[0] >> f[1] >> f[2];
-                tris.push_back({ verts[f[0] - 1], verts[f[1] - 1], verts[f[2] - 1] });
-                
-             
-            }
-        }
-
-        f.close();
-        return true;
-    }
-};
-
-struct Mat4x4 {
-    float m[4][4] = { 0 };
-};
-
-
-class olcEngine3D : public olcConsoleGameEngine {
-private: 
-    Mesh meshCube;
-    Mat4x4 matProj;
-
-    Vec3d vCamera;
-    Vec3d vLookDir;
-
-    float fTheta;
-    float fYaw;
-
-    Vec3d Vector_Add(Vec3d& v1, Vec3d& v2)
-    {
-        return { v1.x + v2.x, v1.y + v2.y, v1.z + v2.z };
-    }
-
-    Vec3d Vector_Sub(Vec3d& v1, Vec3d& v2)
-    {
-        return { v1.x - v2.x, v1.y - v2.y, v1.z - v2.z };
-    }
-
-    Vec3d Vector_Mul(Vec3d& v1, float k)
-    {
-        return { v1.x * k, v1.y * k, v1.z * k };
-    }
-
-    Vec3d Vector_Div(Vec3d& v1, float k)
-    {
-        return { v1.x / k, v1.y / k, v1.z / k };
-    }
-
-    float Vector_DotProduct(Vec3d& v1, Vec3d& v2)
-    {
-        return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
-    }
-
-    float Vector_Length(Vec3d& v)
-    {
-        return sqrtf(Vector_DotProduct(v, v));
-    }
-
-    Vec3d Vector_Normalise(Vec3d& v)
-    {
-        float l = Vector_Length(v);
-        return { v.x / l, v.y / l, v.z / l };
-    }
-
-    Vec3d Vector_CrossProduct(Vec3d& v1, Vec3d& v2)
-    {
-        Vec3d v;
-        v.x = v1.y * v2.z - v1.z * v2.y;
-        v.y = v1.z * v2.x - v1.x * v2.z;
-        v.z = v1.x * v2.y - v1.y * v2.x;
-        return v;
-    }
-
-    Vec3d Matrix_MultiplyVector(Mat4x4& m, Vec3d& i)
-    {
-        Vec3d v;
-        v.x = i.x * m.m[0][0] + i.y * m.m[1][0] + i.z * m.m[2][0] + i.w * m.m[3][0];
-        v.y = i.x * m.m[0][1] + i.y * m.m[1][1] + i.z * m.m[2][1] + i.w * m.m[3][1];
-        v.z = i.x * m.m[0][2] + i.y * m.m[1][2] + i.z * m.m[2][2] + i.w * m.m[3][2];
-        v.w = i.x * m.m[0][3] + i.y * m.m[1][3] + i.z * m.m[2][3] + i.w * m.m[3][3];
-        return v;
-    }
-
-    Vec3d Vector_IntersectPlane(Vec3d& plane_p, Vec3d& plane_n, Vec3d& lineStart, Vec3d& lineEnd)
-    {
-        plane_n = Vector_Normalise(plane_n);
-        float plane_d = -Vector_DotProduct(plane_n, plane_p);
-        float ad = Vector_DotProduct(lineStart, plane_n);
-        float bd = Vector_DotProduct(lineEnd, plane_n);
-        float t = (-plane_d - ad) / (bd - ad);
-        Vec3d lineStartToEnd = Vector_Sub(lineEnd, lineStart);
-        Vec3d lineToIntersect = Vector_Mul(lineStartToEnd, t);
-        return Vector_Add(lineStart, lineToIntersect);
-    }
-
-    int Triangle_ClipAgainstPlane(Vec3d plane_p, Vec3d plane_n, Triangle& in_tri, Triangle& out_tri1, Triangle& out_tri2)
-    {
-        // Make sure plane normal is indeed normal
-        plane_n = Vector_Normalise(plane_n);
-
-        // Return signed shortest distance from point to plane, plane normal must be normalised
-        auto dist = [&](Vec3d& p)
-        {
-            Vec3d n = Vector_Normalise(p);
-            return (plane_n.x * p.x + plane_n.y * p.y + plane_n.z * p.z - Vector_DotProduct(plane_n, plane_p));
-        };
-
-        // Create two temporary storage arrays to classify points either side of plane
-        // If distance sign is positive, point lies on "inside" of plane
-        Vec3d* inside_points[3];  int nInsidePointCount = 0;
-        Vec3d* outside_points[3]; int nOutsidePointCount = 0;
-
-        // Get signed distance of each point in triangle to plane
-        float d0 = dist(in_tri.p[0]);
-        float d1 = dist(in_tri.p[1]);
-        float d2 = dist(in_tri.p[2]);
-
-        if (d0 >= 0) { inside_points[nInsidePointCount++] = &in_tri.p[0]; }
-        else { outside_points[nOutsidePointCount++] = &in_tri.p[0]; }
-        if (d1 >= 0) { inside_points[nInsidePointCount++] = &in_tri.p[1]; }
-        else { outside_points[nOutsidePointCount++] = &in_tri.p[1]; }
-        if (d2 >= 0) { inside_points[nInsidePointCount++] = &in_tri.p[2]; }
-        else { outside_points[nOutsidePointCount++] = &in_tri.p[2]; }
-
-        // Now classify triangle points, and break the input triangle into 
-        // smaller output triangles if required. There are four possible
-        // outcomes...
-
-        if (nInsidePointCount == 0)
-        {
-            // All points lie on the outside of plane, so clip whole triangle
-            // It ceases to exist
-
-            return 0; // No returned triangles are valid
-        }
-
-        if (nInsidePointCount == 3)
-        {
-            // All points lie on the inside of plane, so do nothing
-            // and allow the triangle to simply pass through
-            out_tri1 = in_tri;
-
-            return 1; // Just the one returned original triangle is valid
-        }
+int main(int argc, char* argv[])
+{   
+    olcEngine3D engine;
 
-        if (nInsidePointCount == 1 && nOutsidePointCount == 2)
+    // "--depth" starts with the depth buffer on instead of the painter's sort,
+    // Z toggles it while running. "--tiled" rasterizes on every core,
+    // "--parallel-geometry" transforms and projects on every core, and
+    // "--terrain-lod" draws the mesh as terrain with distance level of detail.
+    // "--half-space" fills triangles by edge functions over 8x8 blocks,
+    // "--dither" shades them with an ordered dither between shades,
+    // "--terminal-repeat" lets a VT terminal repeat runs of identical cells,
+    // and "--present sync|latest|fifo" picks how frames reach the screen
+    bool bHeadless = false;
+    int nFrames = 0;
+    for (int a = 1; a < argc; a++)
+    {
+        std::string arg = argv[a];
+        if (arg == "--depth")
+            engine.SetDepthBuffer(true);
+        else if (arg == "--tiled")
+            engine.SetTiledRaster(true);
+        else if (arg == "--parallel-geometry")
+            engine.SetParallelGeometry(true);
+        else if (arg == "--terrain-lod")
+            engine.SetTerrainLod(true);
+        else if (arg == "--half-space")
+            engine.SetHalfSpaceRaster(true);
+        else if (arg == "--dither")
+            engine.SetDither(true);
+        else if (arg == "--terminal-repeat")
+            engine.SetTerminalRepeat(true);
+        else if (arg == "--present")
         {
-            // Triangle should be clipped. As two points lie outside
-            // the plane, the triangle simply becomes a smaller triangle
-
-            // Copy appearance info to new triangle
-            out_tri1.col = in_tri.col;
-            out_tri1.sym = in_tri.sym;
-
-            // The inside point is valid, so keep that...
-            out_tri1.p[0] = *inside_points[0];
-
-            // but the two new points are at the locations where the 
-            // original sides of the triangle (lines) intersect with the plane
-            out_tri1.p[1] = Vector_IntersectPlane(plane_p, plane_n, *inside_points[0], *outside_points[0]);
-            out_tri1.p[2] = Vector_IntersectPlane(plane_p, plane_n, *inside_points[0], *outside_points[1]);
-
-            return 1; // Return the newly formed single triangle
+            std::string mode = a + 1 < argc ? argv[++a] : "";
+            if (mode == "sync")
+                engine.SetPresentMode(olcEngine3D::PRESENT_SYNC);
+            else if (mode == "latest")
+                engine.SetPresentMode(olcEngine3D::PRESENT_LATEST);
+            else if (mode == "fifo")
+                engine.SetPresentMode(olcEngine3D::PRESENT_FIFO);
+            else
+            {
+                fprintf(stderr, "ERROR: --present takes sync, latest or fifo, not \"%s\"\n", mode.c_str());
+                return 1;
+            }
         }
-
-        if (nInsidePointCount == 2 && nOutsidePointCount == 1)
+        else if (arg == "--headless")
         {
-            // Triangle should be clipped. As two points lie inside the plane,
-            // the clipped triangle becomes a "quad". Fortunately, we can
-            // represent a quad with two new triangles
-
-            // Copy appearance info to new triangles
-            out_tri1.col = in_tri.col;
-            out_tri1.sym = in_tri.sym;
-
-            out_tri2.col = in_tri.col;
-            out_tri2.sym = in_tri.sym;
-
-            // The first triangle consists of the two inside points and a new
-            // point determined by the location where one side of the triangle
-            // intersects with the plane
-            out_tri1.p[0] = *inside_points[0];
-            out_tri1.p[1] = *inside_points[1];
-            out_tri1.p[2] = Vector_IntersectPlane(plane_p, plane_n, *inside_points[0], *outside_points[0]);
-
-            // The second triangle is composed of one of he inside points, a
-            // new point determined by the intersection of the other side of the 
-            // triangle and the plane, and the newly created point above
-            out_tri2.p[0] = *inside_points[1];
-            out_tri2.p[1] = out_tri1.p[2];
-            out_tri2.p[2] = Vector_IntersectPlane(plane_p, plane_n, *inside_points[1], *outside_points[0]);
-
-            return 2; // Return two newly formed triangles which form a quad
+            bHeadless = true;
+            if (a + 1 < argc && isdigit((unsigned char)argv[a + 1][0]))
+                nFrames = atoi(argv[++a]);
         }
     }
 
-
-    Mat4x4 Matrix_MakeIdentity()
-    {
-        Mat4x4 matrix;
-        matrix.m[0][0] = 1.0f;
-        matrix.m[1][1] = 1.0f;
-        matrix.m[2][2] = 1.0f;
-        matrix.m[3][3] = 1.0f;
-        return matrix;
-    }
-
-    Mat4x4 Matrix_MakeRotationX(float fAngleRad)
-    {
-        Mat4x4 matrix;
-        matrix.m[0][0] = 1.0f;
-        matrix.m[1][1] = cosf(fAngleRad);
-        matrix.m[1][2] = sinf(fAngleRad);
-        matrix.m[2][1] = -sinf(fAngleRad);
-        matrix.m[2][2] = cosf(fAngleRad);
-        matrix.m[3][3] = 1.0f;
-        return matrix;
-    }
-
-    Mat4x4 Matrix_MakeRotationY(float fAngleRad)
+    // "--headless [frames]" renders off-screen with no console, e.g. for profiling
+    if (bHeadless)
     {
-        Mat4x4 matrix;
-        matrix.m[0][0] = cosf(fAngleRad);
-        matrix.m[0][2] = sinf(fAngleRad);
-        matrix.m[2][0] = -sinf(fAngleRad);
-        matrix.m[1][1] = 1.0f;
-        matrix.m[2][2] = cosf(fAngleRad);
-        matrix.m[3][3] = 1.0f;
-        return matrix;
+        if (engine.ConstructHeadless(256, 240, nFrames))
+            engine.Start();
+#ifdef OLC_PROFILE
+        engine.Profiler().Report(stderr);
+#endif
+        return 0;
     }
 
-    Mat4x4 Matrix_MakeRotationZ(float fAngleRad)
-    {
-        Mat4x4 matrix;
-        matrix.m[0][0] = cosf(fAngleRad);
-        matrix.m[0][1] = sinf(fAngleRad);
-        matrix.m[1][0] = -sinf(fAngleRad);
-        matrix.m[1][1] = cosf(fAngleRad);
-        matrix.m[2][2] = 1.0f;
-        matrix.m[3][3] = 1.0f;
-        return matrix;
-    }
-
-    Mat4x4 Matrix_MakeTranslation(float x, float y, float z)
-    {
-        Mat4x4 matrix;
-        matrix.m[0][0] = 1.0f;
-        matrix.m[1][1] = 1.0f;
-        matrix.m[2][2] = 1.0f;
-        matrix.m[3][3] = 1.0f;
-        matrix.m[3][0] = x;
-        matrix.m[3][1] = y;
-        matrix.m[3][2] = z;
-        return matrix;
-    }
-
-    Mat4x4 Matrix_MakeProjection(float fFovDegrees, float fAspectRatio, float fNear, float fFar)
-    {
-        float fFovRad = 1.0f / tanf(fFovDegrees * 0.5f / 180.0f * 3.14159f);
-        Mat4x4 matrix;
-        matrix.m[0][0] = fAspectRatio * fFovRad;
-        matrix.m[1][1] = fFovRad;
-        matrix.m[2][2] = fFar / (fFar - fNear);
-        matrix.m[3][2] = (-fFar * fNear) / (fFar - fNear);
-        matrix.m[2][3] = 1.0f;
-        matrix.m[3][3] = 0.0f;
-        return matrix;
-    }
-
-    Mat4x4 Matrix_MultiplyMatrix(Mat4x4& m1, Mat4x4& m2)
-    {
-        Mat4x4 matrix;
-        for (int c = 0; c < 4; c++)
-            for (int r = 0; r < 4; r++)
-                matrix.m[r][c] = m1.m[r][0] * m2.m[0][c] + m1.m[r][1] * m2.m[1][c] + m1.m[r][2] * m2.m[2][c] + m1.m[r][3] * m2.m[3][c];
-        return matrix;
-    }
-
-    Mat4x4 Matrix_PointAt(Vec3d& pos, Vec3d& target, Vec3d& up)
-    {
-        // Calculate new forward direction
-        Vec3d newForward = Vector_Sub(target, pos);
-        newForward = Vector_Normalise(newForward);
-
-        // Calculate new Up direction
-        Vec3d a = Vector_Mul(newForward, Vector_DotProduct(up, newForward));
-        Vec3d newUp = Vector_Sub(up, a);
-        newUp = Vector_Normalise(newUp);
-
-        // New Right direction is easy, its just cross product
-        Vec3d newRight = Vector_CrossProduct(newUp, newForward);
-
-        // Construct Dimensioning and Translation Matrix	
-        Mat4x4 matrix;
-        matrix.m[0][0] = newRight.x;	matrix.m[0][1] = newRight.y;	matrix.m[0][2] = newRight.z;	matrix.m[0][3] = 0.0f;
-        matrix.m[1][0] = newUp.x;		matrix.m[1][1] = newUp.y;		matrix.m[1][2] = newUp.z;		matrix.m[1][3] = 0.0f;
-        matrix.m[2][0] = newForward.x;	matrix.m[2][1] = newForward.y;	matrix.m[2][2] = newForward.z;	matrix.m[2][3] = 0.0f;
-        matrix.m[3][0] = pos.x;			matrix.m[3][1] = pos.y;			matrix.m[3][2] = pos.z;			matrix.m[3][3] = 1.0f;
-        return matrix;
-
-    }
-
-    Mat4x4 Matrix_QuickInverse(Mat4x4& m) // Only for Rotation/Translation Matrices
-    {
-        Mat4x4 matrix;
-        matrix.m[0][0] = m.m[0][0]; matrix.m[0][1] = m.m[1][0]; matrix.m[0][2] = m.m[2][0]; matrix.m[0][3] = 0.0f;
-        matrix.m[1][0] = m.m[0][1]; matrix.m[1][1] = m.m[1][1]; matrix.m[1][2] = m.m[2][1]; matrix.m[1][3] = 0.0f;
-        matrix.m[2][0] = m.m[0][2]; matrix.m[2][1] = m.m[1][2]; matrix.m[2][2] = m.m[2][2]; matrix.m[2][3] = 0.0f;
-        matrix.m[3][0] = -(m.m[3][0] * matrix.m[0][0] + m.m[3][1] * matrix.m[1][0] + m.m[3][2] * matrix.m[2][0]);
-        matrix.m[3][1] = -(m.m[3][0] * matrix.m[0][1] + m.m[3][1] * matrix.m[1][1] + m.m[3][2] * matrix.m[2][1]);
-        matrix.m[3][2] = -(m.m[3][0] * matrix.m[0][2] + m.m[3][1] * matrix.m[1][2] + m.m[3][2] * matrix.m[2][2]);
-        matrix.m[3][3] = 1.0f;
-        return matrix;
-    }
-
-    CHAR_INFO GetColour(float lum)
-    {
-        short bg_col, fg_col;
-        wchar_t sym;
-        int pixel_bw = (int)(13.0f * lum);
-        switch (pixel_bw)
-        {
-        case 0: bg_col = BG_BLACK; fg_col = FG_BLACK; sym = PIXEL_SOLID; break;
-
-        case 1: bg_col = BG_BLACK; fg_col = FG_DARK_GREY; sym = PIXEL_QUARTER; break;
-        case 2: bg_col = BG_BLACK; fg_col = FG_DARK_GREY; sym = PIXEL_HALF; break;
-        case 3: bg_col = BG_BLACK; fg_col = FG_DARK_GREY; sym = PIXEL_THREEQUARTERS; break;
-        case 4: bg_col = BG_BLACK; fg_col = FG_DARK_GREY; sym = PIXEL_SOLID; break;
-
-        case 5: bg_col = BG_DARK_GREY; fg_col = FG_GREY; sym = PIXEL_QUARTER; break;
-        case 6: bg_col = BG_DARK_GREY; fg_col = FG_GREY; sym = PIXEL_HALF; break;
-        case 7: bg_col = BG_DARK_GREY; fg_col = FG_GREY; sym = PIXEL_THREEQUARTERS; break;
-        case 8: bg_col = BG_DARK_GREY; fg_col = FG_GREY; sym = PIXEL_SOLID; break;
-
-        case 9:  bg_col = BG_GREY; fg_col = FG_WHITE; sym = PIXEL_QUARTER; break;
-        case 10: bg_col = BG_GREY; fg_col = FG_WHITE; sym = PIXEL_HALF; break;
-        case 11: bg_col = BG_GREY; fg_col = FG_WHITE; sym = PIXEL_THREEQUARTERS; break;
-        case 12: bg_col = BG_GREY; fg_col = FG_WHITE; sym = PIXEL_SOLID; break;
-        default:
-            bg_col = BG_BLACK; fg_col = FG_BLACK; sym = PIXEL_SOLID;
-        }
-
-        CHAR_INFO c;
-        c.Attributes = bg_col | fg_col;
-        c.Char.UnicodeChar = sym;
-        return c;
-    }
-
-
-public:
-    olcEngine3D(){
-        m_sAppName = L"3D Demo";
-    }
-
-public:
-    bool OnUserCreate() override{
-
-        meshCube.loadFromObjectFile("mountains.obj");
-
-        //Projection Matrix
-        matProj = Matrix_MakeProjection(90.f, (float)ScreenHeight()/(float)ScreenWidth(), 0.1f, 1000.0f);
-
-        return true;
-    }
-
-public:
-    bool OnUserUpdate(float fElapsedTime) override {
-        if (GetKey(VK_UP).bHeld)
-            vCamera.y += 8.0f * fElapsedTime;
-
-        if (GetKey(VK_DOWN).bHeld)
-            vCamera.y -= 8.0f * fElapsedTime;   
-
-        if (GetKey(VK_RIGHT).bHeld)
-            vCamera.x -= 8.0f * fElapsedTime;
-
-        if (GetKey(VK_LEFT).bHeld)
-            vCamera.x += 8.0f * fElapsedTime;
-
-        Vec3d   vForward = Vector_Mul(vLookDir, 8.0f * fElapsedTime);
-
-        if (GetKey(L'W').bHeld)
-            vCamera = Vector_Add(vCamera, vForward);
-
-        if (GetKey(L'S').bHeld)
-            vCamera = Vector_Sub(vCamera, vForward);
-
-
-        if (GetKey(L'A').bHeld)
-            fYaw -= 2.0f * fElapsedTime;
-
-        if (GetKey(L'D').bHeld)
-            fYaw += 2.0f * fElapsedTime;
-        
-        
- 
-
-        Fill(0, 0, ScreenWidth(), ScreenHeight(), PIXEL_SOLID, FG_BLACK);
-
-        Mat4x4 matRotX, matRotZ;
-        //fTheta += 1.0f * fElapsedTime;
-
-        matRotZ = Matrix_MakeRotationZ(fTheta);
-        matRotX = Matrix_MakeRotationX(fTheta);
-
-        Mat4x4 matTrans;
-        matTrans = Matrix_MakeTranslation(0.0f, 0.0f, 5.0f);
-
-        Mat4x4 matWorld;
-        matWorld = Matrix_MakeIdentity();
-        matWorld = Matrix_MultiplyMatrix(matRotZ, matRotX);
-        matWorld = Matrix_MultiplyMatrix(matWorld, matTrans);
-
-        Vec3d vUp = { 0, 1, 0 };
-        Vec3d vTarget = { 0, 0, 1 };
-        Mat4x4 matCameraRotY = Matrix_MakeRotationY(fYaw);
-        vLookDir = Matrix_MultiplyVector(matCameraRotY, vTarget);
-        vTarget = Vector_Add(vCamera, vLookDir);
-        
-        Mat4x4 matCamera = Matrix_PointAt(vCamera, vTarget, vUp);
-        Mat4x4 matView = Matrix_QuickInverse(matCamera);
-
-
-        std::vector<Triangle> trianglesToRaster;
-
-        //Draw Triangles 
-        for (auto tri : meshCube.tris) {
-            Triangle triProjected, triTransformed, triViewed;
-
-            triTransformed.p[0] = Matrix_MultiplyVector(matWorld, tri.p[0]);
-            triTransformed.p[1] = Matrix_MultiplyVector(matWorld, tri.p[1]);
-            triTransformed.p[2] = Matrix_MultiplyVector(matWorld, tri.p[2]);
-
-            //Normal Calculations
-            Vec3d normal, line1, line2;
-            line1 = Vector_Sub(triTransformed.p[1], triTransformed.p[0]);
-            line2 = Vector_Sub(triTransformed.p[2], triTransformed.p[0]);
-            normal = Vector_CrossProduct(line1, line2);
-            normal = Vector_Normalise(normal);
-            
-            Vec3d vCameraRay = Vector_Sub(triTransformed.p[0], vCamera);
-
-            if (Vector_DotProduct(normal, vCameraRay) < 0.0f)
-            {   
-                //Illumination
-                Vec3d light_direction = { 0.0f, 0.1f, -0.1f };
-                light_direction = Vector_Normalise(light_direction);
-
-
-                float dotProduct = max(0.1f, Vector_DotProduct(light_direction, normal));
-                
-                CHAR_INFO c = GetColour(dotProduct);
-                triTransformed.col = c.Attributes;
-                triTransformed.sym = c.Char.UnicodeChar;
-
-                //World space to View Space
-                triViewed.p[0] = Matrix_MultiplyVector(matView, triTransformed.p[0]);
-                triViewed.p[1] = Matrix_MultiplyVector(matView, triTransformed.p[1]);
-                triViewed.p[2] = Matrix_MultiplyVector(matView, triTransformed.p[2]);
-
-                int nClippedTriangles = 0;
-                Triangle clipped[2];
-                nClippedTriangles = Triangle_ClipAgainstPlane({ 0.0f, 0.0f, 0.1f }, { 0.0f, 0.0f, 1.0f }, triViewed, clipped[0], clipped[1]);
-
-                for (int i = 0; i < nClippedTriangles; i++)
-                {
-
-
-                    //3D to 2D
-                    triProjected.p[0] = Matrix_MultiplyVector(matProj, clipped[0].p[0]);
-                    triProjected.p[1] = Matrix_MultiplyVector(matProj, clipped[0].p[1]);
-                    triProjected.p[2] = Matrix_MultiplyVector(matProj, clipped[0].p[2]);
-
-                    triProjected.col = triTransformed.col;
-                    triProjected.sym = triTransformed.sym;
-
-
-
-                    triProjected.p[0] = Vector_Div(triProjected.p[0], triProjected.p[0].w);
-                    triProjected.p[1] = Vector_Div(triProjected.p[1], triProjected.p[1].w);
-                    triProjected.p[2] = Vector_Div(triProjected.p[2], triProjected.p[2].w);
-
-                    // X/Y are inverted so put them back
-                    triProjected.p[0].x *= -1.0f;
-                    triProjected.p[1].x *= -1.0f;
-                    triProjected.p[2].x *= -1.0f;
-                    triProjected.p[0].y *= -1.0f;
-                    triProjected.p[1].y *= -1.0f;
-                    triProjected.p[2].y *= -1.0f;
-
-                    //Scale into view
-                    Vec3d vOffsetView = { 1,1,0 };
-                    triProjected.p[0] = Vector_Add(triProjected.p[0], vOffsetView);
-                    triProjected.p[1] = Vector_Add(triProjected.p[1], vOffsetView);
-                    triProjected.p[2] = Vector_Add(triProjected.p[2], vOffsetView);
-
-                    triProjected.p[0].x *= 0.5f * (float)ScreenWidth();
-                    triProjected.p[0].y *= 0.5f * (float)ScreenWidth();
-                    triProjected.p[1].x *= 0.5f * (float)ScreenWidth();
-                    triProjected.p[1].y *= 0.5f * (float)ScreenWidth();
-                    triProjected.p[2].x *= 0.5f * (float)ScreenWidth();
-                    triProjected.p[2].y *= 0.5f * (float)ScreenWidth();
-
-                    trianglesToRaster.push_back(triProjected);
-                }
-              
-            }
-        }
-        sort(trianglesToRaster.begin(), trianglesToRaster.end(), 
-            [](Triangle &t1, Triangle &t2){
-
-                float z1 = (t1.p[0].z + t1.p[1].z + t1.p[2].z) / 3.0f;
-                float z2 = (t2.p[0].z + t2.p[1].z + t2.p[2].z) / 3.0f;
-                return z1 > z2;
-                    
-            });
-
-        for (auto triToRaster : trianglesToRaster) {
-            
-            Triangle clipped[2];
-            std::list<Triangle> listTriangles;
-            listTriangles.push_back(triToRaster);
-            int nNewTriangles = 1;
-
-            for (int p = 0; p < 4; p++)
-            {
-                int nTrisToAdd = 0;
-                while (nNewTriangles > 0)
-                {
-                    // Take triangle from front of queue
-                    Triangle test = listTriangles.front();
-                    listTriangles.pop_front();
-                    nNewTriangles--;
-
-                    // Clip it against a plane. We only need to test each 
-                    // subsequent plane, against subsequent new triangles
-                    // as all triangles after a plane clip are guaranteed
-                    // to lie on the inside of the plane. I like how this
-                    // comment is almost completely and utterly justified
-                    switch (p)
-                    {
-                    case 0:	nTrisToAdd = Triangle_ClipAgainstPlane({ 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, test, clipped[0], clipped[1]); break;
-                    case 1:	nTrisToAdd = Triangle_ClipAgainstPlane({ 0.0f, (float)ScreenHeight() - 1, 0.0f }, { 0.0f, -1.0f, 0.0f }, test, clipped[0], clipped[1]); break;
-                    case 2:	nTrisToAdd = Triangle_ClipAgainstPlane({ 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, test, clipped[0], clipped[1]); break;
-                    case 3:	nTrisToAdd = Triangle_ClipAgainstPlane({ (float)ScreenWidth() - 1, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f }, test, clipped[0], clipped[1]); break;
-                    }
-
-                    // Clipping may yield a variable number of triangles, so
-                    // add these new ones to the back of the queue for subsequent
-                    // clipping against next planes
-                    for (int w = 0; w < nTrisToAdd; w++)
-                        listTriangles.push_back(clipped[w]);
-                }
-                nNewTriangles = listTriangles.size();
-            }
-
-
-            // Draw the transformed, viewed, clipped, projected, sorted, clipped triangles
-            for (auto& t : listTriangles)
-            {
-                FillTriangle(t.p[0].x, t.p[0].y, t.p[1].x, t.p[1].y, t.p[2].x, t.p[2].y, t.sym, t.col);
-                //DrawTriangle(t.p[0].x, t.p[0].y, t.p[1].x, t.p[1].y, t.p[2].x, t.p[2].y, PIXEL_SOLID, FG_BLACK);
-            }
-
-        }
-        return true;
-    }
-};
-
-int main()
-{   
-    olcEngine3D engine;
-    if (engine.ConstructConsole(256, 240, 2, 2));
+    // Without a Win32 console, draw on the terminal at whatever size it is
+#ifdef _WIN32
+    if (engine.ConstructConsole(256, 240, 2, 2))
+#else
+    if (engine.ConstructTerminal())
+#endif
         engine.Start();
 
-
+    return 0;
 }   
-
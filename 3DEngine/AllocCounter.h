@@ -0,0 +1,67 @@
+#pragma once
+
+// Global heap allocation counter
+//
+// Replaces the global operator new with one that counts every call, from any
+// thread, so a frame can check it didn't allocate at all. Heap traffic in the
+// frame loop is slow on its own and worse once several threads contend for
+// the allocator, so steady-state frames are meant to make none.
+//
+// Only enabled where OLC_COUNT_ALLOCS is defined, as the Debug configurations
+// do, since counting puts an atomic add on every allocation. Like
+// olcConsoleGameEngine.h this header defines things rather than just
+// declaring them, so it belongs in one translation unit per program.
+
+#ifdef OLC_COUNT_ALLOCS
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+inline std::atomic<uint64_t>& Alloc_Counter()
+{
+    static std::atomic<uint64_t> nCount{ 0 };
+    return nCount;
+}
+
+// Allocations so far, over the whole program
+inline uint64_t Alloc_Count()
+{
+    return Alloc_Counter().load(std::memory_order_relaxed);
+}
+
+// The nothrow and array forms all end up in this one. Over-aligned
+// allocations go through the library's own aligned operator new and aren't
+// counted, nothing in the frame loop makes them
+void* operator new(size_t nBytes)
+{
+    Alloc_Counter().fetch_add(1, std::memory_order_relaxed);
+    if (void* p = malloc(nBytes > 0 ? nBytes : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t nBytes)
+{
+    return operator new(nBytes);
+}
+
+// Kept out of line, so that where a delete is inlined the compiler doesn't
+// see free() given a pointer from operator new and warn about the mismatch
+#if defined(_MSC_VER)
+__declspec(noinline)
+#else
+__attribute__((noinline))
+#endif
+void Alloc_Free(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p) noexcept { Alloc_Free(p); }
+void operator delete[](void* p) noexcept { Alloc_Free(p); }
+void operator delete(void* p, size_t) noexcept { Alloc_Free(p); }
+void operator delete[](void* p, size_t) noexcept { Alloc_Free(p); }
+
+#endif
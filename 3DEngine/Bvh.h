@@ -0,0 +1,238 @@
+#pragma once
+
+// Bounding volume hierarchy for frustum culling
+//
+// The mesh's triangles are split in two at the median of their centres along
+// the longest axis, again and again, until each piece is small enough to be a
+// leaf. Bvh_Build then reorders the mesh depth first, giving every leaf its
+// own vertices - a vertex shared by several leaves is copied into each - so
+// the triangles and the vertices under any node are each one contiguous run.
+// Bvh_Cull walks the tree against a set of planes, drops every subtree whose
+// box is wholly outside one of them, and hands back the runs of what's left,
+// so a frame only transforms and projects the parts of the mesh in view.
+
+#include "Geometry3D.h"
+#include "Clipper.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdint>
+#include <vector>
+
+static const uint32_t BVH_LEAF_TRIANGLES = 64;
+static const int BVH_MAX_DEPTH = 63;        // levels below the root Bvh_Cull can walk
+
+// Nodes are stored depth first: a node's first child comes straight after it,
+// and nSecond is the other one, or 0 for a leaf
+struct BvhNode {
+    float fMin[3];
+    float fMax[3];
+    uint32_t nFirstTri, nTriCount;      // every triangle under the node
+    uint32_t nFirstVert, nVertCount;    // and every vertex
+    uint32_t nSecond;
+    uint32_t nPad;
+};
+
+// A run of triangles or vertices, [nFirst, nLast)
+struct BvhRange {
+    uint32_t nFirst, nLast;
+};
+
+// Split the triangles tris[nFirst, nLast) with centres pCentres into a
+// subtree appended to nodes. Only the triangle side of each node is filled in
+inline void Bvh_Split(std::vector<BvhNode>& nodes, uint32_t* pTris, const Vec3d* pCentres, uint32_t nFirst, uint32_t nLast)
+{
+    uint32_t nNode = (uint32_t)nodes.size();
+    nodes.push_back({});
+    nodes[nNode].nFirstTri = nFirst;
+    nodes[nNode].nTriCount = nLast - nFirst;
+    if (nLast - nFirst <= BVH_LEAF_TRIANGLES)
+        return;
+
+    float fMin[3] = { pCentres[pTris[nFirst]].x, pCentres[pTris[nFirst]].y, pCentres[pTris[nFirst]].z };
+    float fMax[3] = { fMin[0], fMin[1], fMin[2] };
+    for (uint32_t i = nFirst; i < nLast; i++) {
+        const Vec3d& c = pCentres[pTris[i]];
+        float v[3] = { c.x, c.y, c.z };
+        for (int a = 0; a < 3; a++) {
+            fMin[a] = std::min(fMin[a], v[a]);
+            fMax[a] = std::max(fMax[a], v[a]);
+        }
+    }
+
+    int nAxis = 0;
+    for (int a = 1; a < 3; a++)
+        if (fMax[a] - fMin[a] > fMax[nAxis] - fMin[nAxis])
+            nAxis = a;
+
+    auto axis = [&](uint32_t t) { return nAxis == 0 ? pCentres[t].x : nAxis == 1 ? pCentres[t].y : pCentres[t].z; };
+    uint32_t nMid = nFirst + (nLast - nFirst) / 2;
+    std::nth_element(pTris + nFirst, pTris + nMid, pTris + nLast, [&](uint32_t a, uint32_t b) { return axis(a) < axis(b); });
+
+    Bvh_Split(nodes, pTris, pCentres, nFirst, nMid);
+    nodes[nNode].nSecond = (uint32_t)nodes.size();
+    Bvh_Split(nodes, pTris, pCentres, nMid, nLast);
+}
+
+// Build the hierarchy over a mesh, reordering its triangles and vertices to
+// match it. Vertices shared between leaves are duplicated, so verts usually
+// grows a little
+inline void Bvh_Build(std::vector<Vec3d>& verts, std::vector<int>& indices, std::vector<BvhNode>& nodes)
+{
+    nodes.clear();
+    uint32_t nTris = (uint32_t)(indices.size() / 3);
+    if (nTris == 0)
+        return;
+
+    std::vector<Vec3d> vecCentres(nTris);
+    std::vector<uint32_t> vecTris(nTris);
+    for (uint32_t t = 0; t < nTris; t++) {
+        const Vec3d& a = verts[indices[t * 3]];
+        const Vec3d& b = verts[indices[t * 3 + 1]];
+        const Vec3d& c = verts[indices[t * 3 + 2]];
+        vecCentres[t] = { (a.x + b.x + c.x) / 3.0f, (a.y + b.y + c.y) / 3.0f, (a.z + b.z + c.z) / 3.0f };
+        vecTris[t] = t;
+    }
+    Bvh_Split(nodes, vecTris.data(), vecCentres.data(), 0, nTris);
+
+    // Lay the leaves out one after another, each with its own copy of the
+    // vertices it uses. Leaves are in depth first order, so so are their runs
+    std::vector<Vec3d> vecVerts;
+    std::vector<int> vecIndices(indices.size());
+    std::vector<int> vecRemap(verts.size(), -1);
+    std::vector<uint32_t> vecRemapLeaf(verts.size(), UINT32_MAX);
+    vecVerts.reserve(verts.size());
+    for (uint32_t n = 0; n < (uint32_t)nodes.size(); n++) {
+        BvhNode& leaf = nodes[n];
+        if (leaf.nSecond != 0)
+            continue;
+
+        leaf.nFirstVert = (uint32_t)vecVerts.size();
+        leaf.fMin[0] = leaf.fMin[1] = leaf.fMin[2] = FLT_MAX;
+        leaf.fMax[0] = leaf.fMax[1] = leaf.fMax[2] = -FLT_MAX;
+        for (uint32_t i = leaf.nFirstTri; i < leaf.nFirstTri + leaf.nTriCount; i++) {
+            for (int k = 0; k < 3; k++) {
+                int v = indices[vecTris[i] * 3 + k];
+                if (vecRemapLeaf[v] != n) {
+                    vecRemapLeaf[v] = n;
+                    vecRemap[v] = (int)vecVerts.size();
+                    vecVerts.push_back(verts[v]);
+
+                    const Vec3d& p = verts[v];
+                    leaf.fMin[0] = std::min(leaf.fMin[0], p.x); leaf.fMax[0] = std::max(leaf.fMax[0], p.x);
+                    leaf.fMin[1] = std::min(leaf.fMin[1], p.y); leaf.fMax[1] = std::max(leaf.fMax[1], p.y);
+                    leaf.fMin[2] = std::min(leaf.fMin[2], p.z); leaf.fMax[2] = std::max(leaf.fMax[2], p.z);
+                }
+                vecIndices[i * 3 + k] = vecRemap[v];
+            }
+        }
+        leaf.nVertCount = (uint32_t)vecVerts.size() - leaf.nFirstVert;
+    }
+
+    // Interior nodes cover both children, which come after them
+    for (uint32_t n = (uint32_t)nodes.size(); n-- > 0;) {
+        BvhNode& node = nodes[n];
+        if (node.nSecond == 0)
+            continue;
+
+        const BvhNode& a = nodes[n + 1];
+        const BvhNode& b = nodes[node.nSecond];
+        for (int k = 0; k < 3; k++) {
+            node.fMin[k] = std::min(a.fMin[k], b.fMin[k]);
+            node.fMax[k] = std::max(a.fMax[k], b.fMax[k]);
+        }
+        node.nFirstVert = a.nFirstVert;
+        node.nVertCount = b.nFirstVert + b.nVertCount - a.nFirstVert;
+    }
+
+    verts = std::move(vecVerts);
+    indices = std::move(vecIndices);
+}
+
+// Add [nFirst, nLast) to the runs in pRanges, joining it onto the last one
+// where they meet but never letting a run grow past nMaxLength
+inline void Bvh_AddRange(BvhRange* pRanges, size_t& nRanges, uint32_t nFirst, uint32_t nLast, uint32_t nMaxLength)
+{
+    while (nFirst < nLast) {
+        if (nRanges > 0 && pRanges[nRanges - 1].nLast == nFirst && pRanges[nRanges - 1].nLast - pRanges[nRanges - 1].nFirst < nMaxLength) {
+            BvhRange& r = pRanges[nRanges - 1];
+            r.nLast = std::min(nLast, r.nFirst + nMaxLength);
+            nFirst = r.nLast;
+        }
+        else {
+            pRanges[nRanges++] = { nFirst, std::min(nLast, nFirst + nMaxLength) };
+            nFirst = pRanges[nRanges - 1].nLast;
+        }
+    }
+}
+
+// The most runs Bvh_Cull can produce for nCount items in nNodes nodes
+inline size_t Bvh_MaxRanges(size_t nNodes, size_t nCount, uint32_t nMaxLength)
+{
+    return nNodes + nCount / nMaxLength + 1;
+}
+
+// Test the box [fMin, fMax] against the planes in nPlaneMask, returning false
+// if it's wholly outside any of them. The corner furthest along each plane's
+// normal is tested, and the nearest: if the furthest is outside the whole box
+// is, and if the nearest is inside so is the whole box, and that plane is
+// taken out of the mask so nothing inside the box need test it again
+inline bool Bvh_TestBox(const float* fMin, const float* fMax, const ClipPlane* pPlanes, int nPlanes, uint32_t& nPlaneMask)
+{
+    for (int p = 0; p < nPlanes; p++) {
+        if ((nPlaneMask & (1u << p)) == 0)
+            continue;
+        const ClipPlane& pl = pPlanes[p];
+        float fFar = pl.d, fNear = pl.d;
+        fFar += pl.a * (pl.a > 0.0f ? fMax[0] : fMin[0]);
+        fNear += pl.a * (pl.a > 0.0f ? fMin[0] : fMax[0]);
+        fFar += pl.b * (pl.b > 0.0f ? fMax[1] : fMin[1]);
+        fNear += pl.b * (pl.b > 0.0f ? fMin[1] : fMax[1]);
+        fFar += pl.c * (pl.c > 0.0f ? fMax[2] : fMin[2]);
+        fNear += pl.c * (pl.c > 0.0f ? fMin[2] : fMax[2]);
+        if (fFar < 0.0f)
+            return false;
+        if (fNear >= 0.0f)
+            nPlaneMask &= ~(1u << p);
+    }
+    return true;
+}
+
+// Cull the tree against planes in the mesh's own space, a*x + b*y + c*z + d
+// >= 0 inside, and write the runs of triangles and vertices that are left, in
+// mesh order, to pTris and pVerts, which need room for Bvh_MaxRanges. Runs are
+// kept under nMaxTris and nMaxVerts long so they can be handed out as jobs
+inline void Bvh_Cull(const BvhNode* pNodes, size_t nNodes, const ClipPlane* pPlanes, int nPlanes,
+    BvhRange* pTris, size_t& nTriRanges, uint32_t nMaxTris, BvhRange* pVerts, size_t& nVertRanges, uint32_t nMaxVerts)
+{
+    nTriRanges = nVertRanges = 0;
+    if (nNodes == 0)
+        return;
+
+    // Each entry is a node and the planes its parent wasn't already wholly
+    // inside. The tree is only as deep as the mesh has doublings of triangles,
+    // and a node at depth d leaves at most d + 2 entries
+    struct Entry { uint32_t nNode, nPlaneMask; };
+    Entry stack[BVH_MAX_DEPTH + 1];
+    int nStack = 0;
+    stack[nStack++] = { 0, (1u << nPlanes) - 1 };
+
+    while (nStack > 0) {
+        Entry e = stack[--nStack];
+        const BvhNode& node = pNodes[e.nNode];
+
+        if (!Bvh_TestBox(node.fMin, node.fMax, pPlanes, nPlanes, e.nPlaneMask))
+            continue;
+
+        if (node.nSecond == 0 || e.nPlaneMask == 0) {
+            Bvh_AddRange(pTris, nTriRanges, node.nFirstTri, node.nFirstTri + node.nTriCount, nMaxTris);
+            Bvh_AddRange(pVerts, nVertRanges, node.nFirstVert, node.nFirstVert + node.nVertCount, nMaxVerts);
+            continue;
+        }
+
+        // Second child first, so the first comes off the stack first and the
+        // runs come out in mesh order
+        stack[nStack++] = { node.nSecond, e.nPlaneMask };
+        stack[nStack++] = { e.nNode + 1, e.nPlaneMask };
+    }
+}
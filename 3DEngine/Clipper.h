@@ -0,0 +1,112 @@
+#pragma once
+
+// Triangle clipping in homogeneous clip space
+//
+// Vertices are clipped after the projection matrix but before the divide by
+// w, where every side of the view volume is a plane through the origin and a
+// straight line stays straight, so one Sutherland-Hodgman pass can take a
+// triangle through all of them. The polygon lives in fixed arrays on the
+// stack. Each vertex gets an outcode, one bit per plane it's outside of, so a
+// triangle wholly outside one plane is dropped and one wholly inside all of
+// them passes straight through, and the rest only visit the planes they cross.
+
+#include "Geometry3D.h"
+
+#include <utility>
+
+// Points where a*x + b*y + c*z + d*w >= 0 are inside
+struct ClipPlane {
+    float a, b, c, d;
+};
+
+static const int CLIP_MAX_PLANES = 6;
+
+// Clipping a convex polygon by a plane adds at most one vertex
+static const int CLIP_MAX_VERTS = 3 + CLIP_MAX_PLANES;
+
+// and what's left of a triangle fans out into at most this many
+static const int CLIP_MAX_FAN = CLIP_MAX_VERTS - 2;
+
+inline float Clip_Distance(const ClipPlane& p, const Vec3d& v)
+{
+    return p.a * v.x + p.b * v.y + p.c * v.z + p.d * v.w;
+}
+
+// Bit n set if v is outside plane n
+inline unsigned Clip_Outcode(const ClipPlane* planes, int nPlanes, const Vec3d& v)
+{
+    unsigned nCode = 0;
+    for (int p = 0; p < nPlanes; p++)
+        if (Clip_Distance(planes[p], v) < 0.0f)
+            nCode |= 1u << p;
+    return nCode;
+}
+
+// Where the edge from inside to outside crosses the plane. Always measured from
+// the inside end, so the two triangles sharing an edge get the same point
+inline Vec3d Clip_Intersect(const Vec3d& inside, const Vec3d& outside, float dIn, float dOut)
+{
+    float t = dIn / (dIn - dOut);
+    return {
+        inside.x + (outside.x - inside.x) * t,
+        inside.y + (outside.y - inside.y) * t,
+        inside.z + (outside.z - inside.z) * t,
+        inside.w + (outside.w - inside.w) * t
+    };
+}
+
+// Clip triangle v0 v1 v2, whose vertices have outcodes c0 c1 c2, against the
+// planes and write what's left, a convex polygon in the same winding, to out,
+// which must have room for CLIP_MAX_VERTS. Returns the number of vertices, 0
+// if nothing is left. Outcodes can be worked out once per vertex of a mesh
+// rather than once per triangle that uses it
+inline int Clip_Triangle(const ClipPlane* planes, int nPlanes, const Vec3d& v0, const Vec3d& v1, const Vec3d& v2,
+    unsigned c0, unsigned c1, unsigned c2, Vec3d* out)
+{
+    if (c0 & c1 & c2)
+        return 0;
+
+    out[0] = v0;
+    out[1] = v1;
+    out[2] = v2;
+    unsigned nCrossed = c0 | c1 | c2;
+    if (nCrossed == 0)
+        return 3;
+
+    Vec3d buf[CLIP_MAX_VERTS];
+    Vec3d* pIn = out;
+    Vec3d* pOut = buf;
+    int n = 3;
+
+    for (int p = 0; p < nPlanes; p++) {
+        if ((nCrossed & (1u << p)) == 0)
+            continue;
+
+        int m = 0;
+        float dPrev = Clip_Distance(planes[p], pIn[n - 1]);
+        for (int i = 0, j = n - 1; i < n; j = i++) {
+            float d = Clip_Distance(planes[p], pIn[i]);
+            if ((d >= 0.0f) != (dPrev >= 0.0f))
+                pOut[m++] = d >= 0.0f ? Clip_Intersect(pIn[i], pIn[j], d, dPrev) : Clip_Intersect(pIn[j], pIn[i], dPrev, d);
+            if (d >= 0.0f)
+                pOut[m++] = pIn[i];
+            dPrev = d;
+        }
+
+        std::swap(pIn, pOut);
+        n = m;
+        if (n < 3)
+            return 0;
+    }
+
+    if (pIn != out)
+        for (int i = 0; i < n; i++)
+            out[i] = pIn[i];
+    return n;
+}
+
+inline int Clip_Triangle(const ClipPlane* planes, int nPlanes, const Vec3d& v0, const Vec3d& v1, const Vec3d& v2, Vec3d* out)
+{
+    return Clip_Triangle(planes, nPlanes, v0, v1, v2,
+        Clip_Outcode(planes, nPlanes, v0), Clip_Outcode(planes, nPlanes, v1), Clip_Outcode(planes, nPlanes, v2), out);
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+// Back to front ordering for the painter's algorithm
+//
+// Each triangle gets one 32 bit key from its depth, worked out once, and it's
+// (key, index) pairs that get sorted rather than the triangles themselves -
+// the triangles are moved once at the end into their final places. Keys are
+// sorted by an LSD radix sort a byte at a time, which is stable, so triangles
+// at the same depth stay in index order and the order depends only on the
+// keys.
+//
+// From one frame to the next the order hardly changes unless the camera jumps,
+// so DepthSort_Insertion can start from the last frame's order and insertion
+// sort what moved. It gives up once it's moved too many, and then the radix
+// sort does it instead. Triangles that weren't there last frame are sorted on
+// their own and put in with DepthSort_Merge. All of them break ties by index,
+// so every way round gives the same order.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+// Keys sort nearest last: deeper z gives a smaller key. The float's bits are
+// flipped so that comparing them as unsigned integers orders the floats
+inline uint32_t DepthSort_Key(float z)
+{
+    uint32_t u;
+    memcpy(&u, &z, sizeof(u));
+    u = (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+    return ~u;
+}
+
+// Sort keys ascending, carrying indices along. The tmp arrays must hold n
+// each. Ties keep the order they came in
+inline void DepthSort_Radix(uint32_t* pKeys, uint32_t* pIndices, uint32_t* pTmpKeys, uint32_t* pTmpIndices, size_t n)
+{
+    if (n < 2)
+        return;
+
+    // One pass to count every byte of every key
+    uint32_t nCount[4][256] = {};
+    for (size_t i = 0; i < n; i++) {
+        uint32_t k = pKeys[i];
+        nCount[0][k & 0xff]++;
+        nCount[1][(k >> 8) & 0xff]++;
+        nCount[2][(k >> 16) & 0xff]++;
+        nCount[3][k >> 24]++;
+    }
+
+    uint32_t* pInKeys = pKeys;
+    uint32_t* pInIndices = pIndices;
+    uint32_t* pOutKeys = pTmpKeys;
+    uint32_t* pOutIndices = pTmpIndices;
+    for (int b = 0; b < 4; b++) {
+        int nShift = b * 8;
+
+        // A byte every key shares doesn't change the order, which is usually
+        // the case for the top one as depths are close together
+        if (nCount[b][(pInKeys[0] >> nShift) & 0xff] == n)
+            continue;
+
+        uint32_t nOffset[256];
+        uint32_t nSum = 0;
+        for (int d = 0; d < 256; d++) {
+            nOffset[d] = nSum;
+            nSum += nCount[b][d];
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            uint32_t o = nOffset[(pInKeys[i] >> nShift) & 0xff]++;
+            pOutKeys[o] = pInKeys[i];
+            pOutIndices[o] = pInIndices[i];
+        }
+        std::swap(pInKeys, pOutKeys);
+        std::swap(pInIndices, pOutIndices);
+    }
+
+    if (pInKeys != pKeys) {
+        memcpy(pKeys, pInKeys, n * sizeof(uint32_t));
+        memcpy(pIndices, pInIndices, n * sizeof(uint32_t));
+    }
+}
+
+// Sort (key, index) pairs that are nearly in order already, ties by index.
+// Returns false, leaving them only partly sorted, as soon as more than
+// nMaxMoves pairs have had to shift along
+inline bool DepthSort_Insertion(uint32_t* pKeys, uint32_t* pIndices, size_t n, size_t nMaxMoves)
+{
+    size_t nMoves = 0;
+    for (size_t i = 1; i < n; i++) {
+        uint32_t k = pKeys[i], idx = pIndices[i];
+        uint64_t nPair = ((uint64_t)k << 32) | idx;
+        size_t j = i;
+        while (j > 0 && (((uint64_t)pKeys[j - 1] << 32) | pIndices[j - 1]) > nPair) {
+            pKeys[j] = pKeys[j - 1];
+            pIndices[j] = pIndices[j - 1];
+            j--;
+            nMoves++;
+        }
+        pKeys[j] = k;
+        pIndices[j] = idx;
+
+        if (nMoves > nMaxMoves)
+            return false;
+    }
+    return true;
+}
+
+// Merge two sorted runs of (key, index) pairs into out, ties by index
+inline void DepthSort_Merge(const uint32_t* pKeysA, const uint32_t* pIndicesA, size_t nA,
+    const uint32_t* pKeysB, const uint32_t* pIndicesB, size_t nB, uint32_t* pOutKeys, uint32_t* pOutIndices)
+{
+    size_t a = 0, b = 0, o = 0;
+    while (a < nA && b < nB) {
+        bool bTakeA = pKeysA[a] != pKeysB[b] ? pKeysA[a] < pKeysB[b] : pIndicesA[a] < pIndicesB[b];
+        if (bTakeA) {
+            pOutKeys[o] = pKeysA[a];
+            pOutIndices[o++] = pIndicesA[a++];
+        }
+        else {
+            pOutKeys[o] = pKeysB[b];
+            pOutIndices[o++] = pIndicesB[b++];
+        }
+    }
+    for (; a < nA; a++, o++) {
+        pOutKeys[o] = pKeysA[a];
+        pOutIndices[o] = pIndicesA[a];
+    }
+    for (; b < nB; b++, o++) {
+        pOutKeys[o] = pKeysB[b];
+        pOutIndices[o] = pIndicesB[b];
+    }
+}
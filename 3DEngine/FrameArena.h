@@ -0,0 +1,67 @@
+#pragma once
+
+// Scratch memory that lives for one frame
+//
+// A bump allocator: Alloc just moves an offset along one block, and Reset at
+// the top of the next frame hands the whole block back at once. A frame that
+// needs more than the block holds gets the rest from overflow blocks, and the
+// next Reset swaps them all for a single block big enough for that frame, so
+// once frames stop growing the arena stops touching the heap.
+//
+// Nothing is ever destructed, so only trivially destructible types go in it,
+// and the memory comes back uninitialised.
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+class FrameArena {
+public:
+    FrameArena() = default;
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // Free everything allocated since the last Reset
+    void Reset() {
+        if (!vecOverflow.empty()) {
+            size_t nNeeded = nUsed + nOverflowBytes;
+            vecOverflow.clear();
+            nOverflowBytes = 0;
+            nCapacity = nNeeded + nNeeded / 2;
+            pBlock.reset(new unsigned char[nCapacity]);
+        }
+        nUsed = 0;
+    }
+
+    // Room for n Ts, valid until the next Reset
+    template <typename T>
+    T* Alloc(size_t n) {
+        static_assert(std::is_trivially_destructible<T>::value, "FrameArena never runs destructors");
+        static_assert(alignof(T) <= alignof(std::max_align_t), "FrameArena blocks are only max_align_t aligned");
+
+        size_t nBytes = n * sizeof(T);
+        size_t nStart = (nUsed + alignof(T) - 1) & ~(alignof(T) - 1);
+        if (nStart + nBytes <= nCapacity) {
+            nUsed = nStart + nBytes;
+            return reinterpret_cast<T*>(pBlock.get() + nStart);
+        }
+
+        vecOverflow.emplace_back(new unsigned char[nBytes]);
+        nOverflowBytes += nBytes;
+        return reinterpret_cast<T*>(vecOverflow.back().get());
+    }
+
+    size_t Capacity() const { return nCapacity; }
+
+    // Whether anything since the last Reset had to come from overflow blocks
+    bool Overflowed() const { return !vecOverflow.empty(); }
+
+private:
+    std::unique_ptr<unsigned char[]> pBlock;
+    size_t nCapacity = 0;
+    size_t nUsed = 0;
+
+    std::vector<std::unique_ptr<unsigned char[]>> vecOverflow;
+    size_t nOverflowBytes = 0;
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+struct Vec3d {
+    float 
+        x = 0,
+        y = 0,
+        z = 0,
+        w = 1;
+};
+
+struct Triangle {
+    Vec3d p[3];
+    wchar_t sym;
+    short col;
+    uint16_t shade;     // Shade_Index() of its light, for dithering
+    uint32_t nSource;   // the mesh triangle it was projected from
+};
+
+struct Mat4x4 {
+    float m[4][4] = { 0 };
+};
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read-only view of a whole file
+class MappedFile {
+public:
+    MappedFile() {}
+    MappedFile(const std::string& sFileName) { Open(sFileName); }
+    ~MappedFile() { Close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& sFileName) {
+        Close();
+#ifdef _WIN32
+        hFile = CreateFileA(sFileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (hFile == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(hFile, &size)) {
+            Close();
+            return false;
+        }
+        nSize = (size_t)size.QuadPart;
+
+        // Empty files can't be mapped, but are still valid (and empty)
+        if (nSize > 0) {
+            hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (hMapping != nullptr)
+                pData = (const char*)MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+            if (pData == nullptr) {
+                Close();
+                return false;
+            }
+        }
+#else
+        int fd = open(sFileName.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            return false;
+        }
+        nSize = (size_t)st.st_size;
+
+        if (nSize > 0) {
+            void* p = mmap(nullptr, nSize, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                close(fd);
+                nSize = 0;
+                return false;
+            }
+            madvise(p, nSize, MADV_SEQUENTIAL);
+            pData = (const char*)p;
+        }
+        close(fd);
+#endif
+        bOpen = true;
+        return true;
+    }
+
+    void Close() {
+#ifdef _WIN32
+        if (pData != nullptr)
+            UnmapViewOfFile(pData);
+        if (hMapping != nullptr)
+            CloseHandle(hMapping);
+        if (hFile != INVALID_HANDLE_VALUE)
+            CloseHandle(hFile);
+        hMapping = nullptr;
+        hFile = INVALID_HANDLE_VALUE;
+#else
+        if (pData != nullptr)
+            munmap((void*)pData, nSize);
+#endif
+        pData = nullptr;
+        nSize = 0;
+        bOpen = false;
+    }
+
+    bool IsOpen() const { return bOpen; }
+    const char* Data() const { return pData; }
+    size_t Size() const { return nSize; }
+
+private:
+    const char* pData = nullptr;
+    size_t nSize = 0;
+    bool bOpen = false;
+#ifdef _WIN32
+    HANDLE hFile = INVALID_HANDLE_VALUE;
+    HANDLE hMapping = nullptr;
+#endif
+};
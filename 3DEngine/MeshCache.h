@@ -0,0 +1,261 @@
+#pragma once
+
+// Binary mesh cache
+//
+// The first time an OBJ is loaded its vertex, index and BVH node buffers are
+// written to "<file>.cache" next to it: a small versioned header followed by
+// the raw, 64-byte aligned arrays. Later loads map the cache and point the mesh straight
+// at it, so start-up costs roughly a page fault per page the first frame touches
+// instead of a parse. The cache is only used while it still describes the OBJ:
+// same size and modification time, or failing the time, the same content hash.
+
+#include "Geometry3D.h"
+#include "MappedFile.h"
+#include "Bvh.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+// An array that either owns its elements or views them inside a mapped file
+template <typename T>
+class MeshArray {
+public:
+    MeshArray() {}
+    MeshArray(MeshArray&&) = default;
+    MeshArray& operator=(MeshArray&&) = default;
+    MeshArray(const MeshArray&) = delete;
+    MeshArray& operator=(const MeshArray&) = delete;
+
+    void Assign(std::vector<T>&& vec) {
+        owned = std::move(vec);
+        mapping.reset();
+        pData = owned.data();
+        nSize = owned.size();
+    }
+
+    void Map(std::shared_ptr<MappedFile> file, size_t nOffset, size_t nCount) {
+        owned.clear();
+        owned.shrink_to_fit();
+        mapping = std::move(file);
+        pData = (const T*)(mapping->Data() + nOffset);
+        nSize = nCount;
+    }
+
+    bool IsMapped() const { return mapping != nullptr; }
+
+    const T* data() const { return pData; }
+    size_t size() const { return nSize; }
+    bool empty() const { return nSize == 0; }
+    const T* begin() const { return pData; }
+    const T* end() const { return pData + nSize; }
+    const T& operator[](size_t i) const { return pData[i]; }
+
+private:
+    std::vector<T> owned;
+    std::shared_ptr<MappedFile> mapping;
+    const T* pData = nullptr;
+    size_t nSize = 0;
+};
+
+struct MeshCacheHeader {
+    char     sMagic[8];         // "OLCMESH\0"
+    uint32_t nVersion;
+    uint32_t nVertexSize;       // sizeof(Vec3d) when written, catches layout changes
+    uint64_t nSourceSize;
+    int64_t  nSourceTime;
+    uint64_t nSourceHash;
+    uint64_t nVertexCount;
+    uint64_t nVertexOffset;     // offsets are from the start of the file
+    uint64_t nIndexCount;
+    uint64_t nIndexOffset;
+    uint32_t nNodeSize;         // sizeof(BvhNode) when written
+    uint32_t nPad;
+    uint64_t nNodeCount;
+    uint64_t nNodeOffset;
+};
+
+static const char MESHCACHE_MAGIC[8] = "OLCMESH";
+static const uint32_t MESHCACHE_VERSION = 3;
+static const size_t MESHCACHE_ALIGN = 64;
+
+inline uint64_t MeshCache_Align(uint64_t n)
+{
+    return (n + MESHCACHE_ALIGN - 1) / MESHCACHE_ALIGN * MESHCACHE_ALIGN;
+}
+
+inline std::string MeshCache_FileName(const std::string& sObjFile)
+{
+    return sObjFile + ".cache";
+}
+
+// FNV-1a, only needed when the timestamps disagree
+inline uint64_t MeshCache_Hash(const char* p, size_t n)
+{
+    uint64_t h = 14695981039346656037ull;
+    for (size_t i = 0; i < n; i++)
+        h = (h ^ (uint8_t)p[i]) * 1099511628211ull;
+    return h;
+}
+
+inline bool MeshCache_SourceInfo(const std::string& sObjFile, uint64_t& nSize, int64_t& nTime)
+{
+    std::error_code ec;
+    nSize = (uint64_t)std::filesystem::file_size(sObjFile, ec);
+    if (ec)
+        return false;
+    nTime = (int64_t)std::filesystem::last_write_time(sObjFile, ec).time_since_epoch().count();
+    return !ec;
+}
+
+// Whether a cache's arrays hang together: every index names a vertex,
+// and every node's runs and children lie inside the arrays, with the tree
+// shallow enough for Bvh_Cull. Checked once at load, so the frame loop can
+// trust them however the file was damaged
+inline bool MeshCache_Check(size_t nVerts, const int* pIndices, size_t nIndices, const BvhNode* pNodes, size_t nNodes)
+{
+    if (nIndices % 3 != 0)
+        return false;
+    for (size_t i = 0; i < nIndices; i++)
+        if (pIndices[i] < 0 || (size_t)pIndices[i] >= nVerts)
+            return false;
+
+    // Children come after their parents, so one pass in order finds how deep
+    // each node is along its deepest path
+    std::vector<int> vecDepth(nNodes, 0);
+    size_t nTris = nIndices / 3;
+    for (size_t n = 0; n < nNodes; n++) {
+        const BvhNode& node = pNodes[n];
+        if ((uint64_t)node.nFirstTri + node.nTriCount > nTris || (uint64_t)node.nFirstVert + node.nVertCount > nVerts)
+            return false;
+        if (node.nSecond == 0)
+            continue;
+        if (node.nSecond <= n + 1 || node.nSecond >= nNodes || vecDepth[n] >= BVH_MAX_DEPTH)
+            return false;
+        vecDepth[n + 1] = std::max(vecDepth[n + 1], vecDepth[n] + 1);
+        vecDepth[node.nSecond] = std::max(vecDepth[node.nSecond], vecDepth[n] + 1);
+    }
+    return true;
+}
+
+// Whether nCount items of nItemSize starting at nOffset lie inside a file of
+// nFileSize. Counts come from the file, so this divides rather than
+// multiplies: a corrupt count times the item size can wrap past 64 bits
+inline bool MeshCache_Fits(uint64_t nOffset, uint64_t nCount, uint64_t nItemSize, uint64_t nFileSize)
+{
+    return nOffset <= nFileSize && nCount <= (nFileSize - nOffset) / nItemSize;
+}
+
+// Map the cache for sObjFile into verts, indices and nodes if there is one and
+// it still matches the OBJ
+inline bool MeshCache_Load(const std::string& sObjFile, MeshArray<Vec3d>& verts, MeshArray<int>& indices, MeshArray<BvhNode>& nodes)
+{
+    uint64_t nSourceSize;
+    int64_t nSourceTime;
+    if (!MeshCache_SourceInfo(sObjFile, nSourceSize, nSourceTime))
+        return false;
+
+    std::string sCacheFile = MeshCache_FileName(sObjFile);
+    FILE* f = fopen(sCacheFile.c_str(), "rb");
+    if (f == nullptr)
+        return false;
+
+    MeshCacheHeader header;
+    bool bValid = fread(&header, sizeof(header), 1, f) == 1
+        && memcmp(header.sMagic, MESHCACHE_MAGIC, sizeof(header.sMagic)) == 0
+        && header.nVersion == MESHCACHE_VERSION
+        && header.nVertexSize == sizeof(Vec3d)
+        && header.nNodeSize == sizeof(BvhNode)
+        && header.nVertexOffset % MESHCACHE_ALIGN == 0
+        && header.nIndexOffset % MESHCACHE_ALIGN == 0
+        && header.nNodeOffset % MESHCACHE_ALIGN == 0
+        && header.nSourceSize == nSourceSize;
+    fclose(f);
+    if (!bValid)
+        return false;
+
+    // Copies and checkouts touch the timestamp without changing anything, so
+    // check the contents before giving up, and if they match re-stamp the
+    // cache so the next load doesn't have to hash again
+    if (header.nSourceTime != nSourceTime) {
+        MappedFile source;
+        if (!source.Open(sObjFile) || MeshCache_Hash(source.Data(), source.Size()) != header.nSourceHash)
+            return false;
+
+        header.nSourceTime = nSourceTime;
+        if ((f = fopen(sCacheFile.c_str(), "r+b")) != nullptr) {
+            fwrite(&header, sizeof(header), 1, f);
+            fclose(f);
+        }
+    }
+
+    auto file = std::make_shared<MappedFile>();
+    if (!file->Open(sCacheFile)
+        || !MeshCache_Fits(header.nVertexOffset, header.nVertexCount, sizeof(Vec3d), file->Size())
+        || !MeshCache_Fits(header.nIndexOffset, header.nIndexCount, sizeof(int), file->Size())
+        || !MeshCache_Fits(header.nNodeOffset, header.nNodeCount, sizeof(BvhNode), file->Size()))
+        return false;
+
+    const char* pData = file->Data();
+    if (!MeshCache_Check((size_t)header.nVertexCount, (const int*)(pData + header.nIndexOffset), (size_t)header.nIndexCount,
+            (const BvhNode*)(pData + header.nNodeOffset), (size_t)header.nNodeCount))
+        return false;
+
+    verts.Map(file, (size_t)header.nVertexOffset, (size_t)header.nVertexCount);
+    indices.Map(file, (size_t)header.nIndexOffset, (size_t)header.nIndexCount);
+    nodes.Map(file, (size_t)header.nNodeOffset, (size_t)header.nNodeCount);
+    return true;
+}
+
+// Write the cache for sObjFile. Goes via a temporary file so a reader never
+// sees half a cache, and failure (e.g. a read-only folder) is harmless
+inline bool MeshCache_Save(const std::string& sObjFile, const MeshArray<Vec3d>& verts, const MeshArray<int>& indices, const MeshArray<BvhNode>& nodes)
+{
+    MeshCacheHeader header = {};
+    memcpy(header.sMagic, MESHCACHE_MAGIC, sizeof(header.sMagic));
+    header.nVersion = MESHCACHE_VERSION;
+    header.nVertexSize = sizeof(Vec3d);
+    header.nVertexCount = verts.size();
+    header.nVertexOffset = MeshCache_Align(sizeof(header));
+    header.nIndexCount = indices.size();
+    header.nIndexOffset = MeshCache_Align(header.nVertexOffset + verts.size() * sizeof(Vec3d));
+    header.nNodeSize = sizeof(BvhNode);
+    header.nNodeCount = nodes.size();
+    header.nNodeOffset = MeshCache_Align(header.nIndexOffset + indices.size() * sizeof(int));
+
+    if (!MeshCache_SourceInfo(sObjFile, header.nSourceSize, header.nSourceTime))
+        return false;
+
+    MappedFile source;
+    if (!source.Open(sObjFile))
+        return false;
+    header.nSourceHash = MeshCache_Hash(source.Data(), source.Size());
+
+    std::string sCacheFile = MeshCache_FileName(sObjFile);
+    std::string sTempFile = sCacheFile + ".tmp";
+    FILE* f = fopen(sTempFile.c_str(), "wb");
+    if (f == nullptr)
+        return false;
+
+    static const char padding[MESHCACHE_ALIGN] = {};
+    auto pad = [&](uint64_t nTo) { size_t n = (size_t)(nTo - (uint64_t)ftell(f)); return fwrite(padding, 1, n, f) == n; };
+    bool bWritten = fwrite(&header, sizeof(header), 1, f) == 1
+        && pad(header.nVertexOffset) && fwrite(verts.data(), sizeof(Vec3d), verts.size(), f) == verts.size()
+        && pad(header.nIndexOffset) && fwrite(indices.data(), sizeof(int), indices.size(), f) == indices.size()
+        && pad(header.nNodeOffset) && fwrite(nodes.data(), sizeof(BvhNode), nodes.size(), f) == nodes.size();
+    bWritten = fclose(f) == 0 && bWritten;
+
+    std::error_code ec;
+    if (bWritten)
+        std::filesystem::rename(sTempFile, sCacheFile, ec);
+    if (!bWritten || ec) {
+        std::filesystem::remove(sTempFile, ec);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,218 @@
+#pragma once
+
+// Fast Wavefront OBJ loading
+//
+// The file is memory mapped and parsed in place - no line buffers, no streams,
+// and floats and indices are read by hand - so load time is close to the cost
+// of touching the bytes once. Understands "v x y z" and faces with any number
+// of corners written as "v", "v/vt", "v//vn" or "v/vt/vn", including negative
+// (relative) indices. Polygons are triangulated as fans. Everything else (vt,
+// vn, o, g, usemtl, comments...) is skipped.
+
+#include "Geometry3D.h"
+#include "MappedFile.h"
+
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+struct ObjLoadStats {
+    size_t nBytes = 0;
+    size_t nVertices = 0;
+    size_t nTriangles = 0;
+    float fSeconds = 0.0f;
+
+    float MBPerSecond() const { return fSeconds > 0.0f ? (float)nBytes / (1024.0f * 1024.0f) / fSeconds : 0.0f; }
+};
+
+inline bool Obj_IsSpace(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+inline bool Obj_IsDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// Read a decimal float such as "-12.5", "3" or "1.0e-4" starting at p and move
+// p past it. The significant digits are gathered into an integer and scaled by
+// a power of ten once at the end, which is exact for the short fixed-point
+// numbers exporters write
+inline bool Obj_ParseFloat(const char*& p, const char* end, float& f)
+{
+    static const double pow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+        1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    const char* s = p;
+    bool bNegative = false;
+    if (s < end && (*s == '-' || *s == '+'))
+        bNegative = *s++ == '-';
+
+    uint64_t nMantissa = 0;
+    int nDigits = 0;
+    int nExponent = 0;
+    bool bAnyDigits = false;
+
+    for (; s < end && Obj_IsDigit(*s); s++) {
+        bAnyDigits = true;
+        if (nDigits < 19) {
+            nMantissa = nMantissa * 10 + (*s - '0');
+            if (nMantissa != 0) nDigits++;
+        }
+        else
+            nExponent++;
+    }
+
+    if (s < end && *s == '.') {
+        for (s++; s < end && Obj_IsDigit(*s); s++) {
+            bAnyDigits = true;
+            if (nDigits < 19) {
+                nMantissa = nMantissa * 10 + (*s - '0');
+                if (nMantissa != 0) nDigits++;
+                nExponent--;
+            }
+        }
+    }
+
+    if (!bAnyDigits)
+        return false;
+
+    if (s < end && (*s == 'e' || *s == 'E')) {
+        const char* e = s + 1;
+        bool bNegativeExp = false;
+        if (e < end && (*e == '-' || *e == '+'))
+            bNegativeExp = *e++ == '-';
+        if (e < end && Obj_IsDigit(*e)) {
+            int n = 0;
+            for (; e < end && Obj_IsDigit(*e); e++)
+                if (n < 10000) n = n * 10 + (*e - '0');
+            nExponent += bNegativeExp ? -n : n;
+            s = e;
+        }
+    }
+
+    double d = (double)nMantissa;
+    if (nExponent >= 0 && nExponent <= 22)
+        d *= pow10[nExponent];
+    else if (nExponent < 0 && nExponent >= -22)
+        d /= pow10[-nExponent];
+    else
+        d *= std::pow(10.0, (double)nExponent);
+
+    f = (float)(bNegative ? -d : d);
+    p = s;
+    return true;
+}
+
+// Fails rather than overflow if the number is outside [-INT_MAX, INT_MAX]
+inline bool Obj_ParseInt(const char*& p, const char* end, int& n)
+{
+    const char* s = p;
+    bool bNegative = false;
+    if (s < end && (*s == '-' || *s == '+'))
+        bNegative = *s++ == '-';
+    if (s >= end || !Obj_IsDigit(*s))
+        return false;
+
+    int v = 0;
+    for (; s < end && Obj_IsDigit(*s); s++) {
+        int d = *s - '0';
+        if (v > (INT_MAX - d) / 10)
+            return false;
+        v = v * 10 + d;
+    }
+
+    n = bNegative ? -v : v;
+    p = s;
+    return true;
+}
+
+// Load the vertices of an OBJ file, plus three zero-based indices into them
+// per triangle. Returns false if the file can't be read or is malformed
+inline bool LoadObj(const std::string& sFileName, std::vector<Vec3d>& verts, std::vector<int>& indices, ObjLoadStats* pStats = nullptr)
+{
+    auto tp1 = std::chrono::steady_clock::now();
+
+    MappedFile file;
+    if (!file.Open(sFileName))
+        return false;
+
+    const char* p = file.Data();
+    const char* end = p + file.Size();
+
+    verts.clear();
+    indices.clear();
+
+    // Typical exports run at ~30 bytes per vertex line and about two faces
+    // per vertex, so this avoids most of the regrowth on big files
+    verts.reserve(file.Size() / 90);
+    indices.reserve(file.Size() / 15);
+
+    std::vector<int> polygon;
+
+    auto skipSpaces = [&]() { while (p < end && Obj_IsSpace(*p)) p++; };
+    auto atLineEnd = [&]() { return p >= end || *p == '\n' || *p == '\r' || *p == '#'; };
+
+    while (p < end) {
+        skipSpaces();
+
+        if (end - p > 1 && p[0] == 'v' && Obj_IsSpace(p[1])) {
+            p += 2;
+            Vec3d v;
+            skipSpaces();
+            if (!Obj_ParseFloat(p, end, v.x)) return false;
+            skipSpaces();
+            if (!Obj_ParseFloat(p, end, v.y)) return false;
+            skipSpaces();
+            if (!Obj_ParseFloat(p, end, v.z)) return false;
+            verts.push_back(v);
+        }
+        else if (end - p > 1 && p[0] == 'f' && Obj_IsSpace(p[1])) {
+            p += 2;
+            polygon.clear();
+            for (skipSpaces(); !atLineEnd(); skipSpaces()) {
+                int n;
+                if (!Obj_ParseInt(p, end, n) || n == 0)
+                    return false;
+
+                // Negative indices count back from the last vertex read so far.
+                // Positive ones are checked once the whole file has been read
+                if (n < 0 && (size_t)-(int64_t)n > verts.size())
+                    return false;
+                polygon.push_back(n > 0 ? n - 1 : (int)((int64_t)verts.size() + n));
+
+                // Step over any /vt/vn part, they aren't used
+                while (p < end && !Obj_IsSpace(*p) && *p != '\n' && *p != '\r')
+                    p++;
+            }
+
+            for (size_t k = 1; k + 1 < polygon.size(); k++) {
+                indices.push_back(polygon[0]);
+                indices.push_back(polygon[k]);
+                indices.push_back(polygon[k + 1]);
+            }
+        }
+
+        const char* eol = (const char*)memchr(p, '\n', (size_t)(end - p));
+        p = eol != nullptr ? eol + 1 : end;
+    }
+
+    for (int i : indices)
+        if (i < 0 || (size_t)i >= verts.size())
+            return false;
+
+    if (pStats != nullptr) {
+        pStats->nBytes = file.Size();
+        pStats->nVertices = verts.size();
+        pStats->nTriangles = indices.size() / 3;
+        pStats->fSeconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - tp1).count();
+    }
+    return true;
+}
@@ -0,0 +1,59 @@
+// Checks for LoadObj
+//
+// Writes small OBJ files and checks which ones load and what they load as.
+// Malformed faces, indices past the vertices or past what an int holds among
+// them, have to be rejected rather than handed on to the BVH build.
+//
+//   ObjLoaderTest        exit status 0 if every case passes
+
+#include "ObjLoader.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+static int nFailures = 0;
+
+static void Check(const char* sName, const char* sObj, bool bExpectLoad, const std::vector<int>& vecExpectIndices = {})
+{
+    const char* sFile = "ObjLoaderTest.tmp.obj";
+    FILE* f = fopen(sFile, "wb");
+    if (f == nullptr) {
+        fprintf(stderr, "ERROR: can't write %s\n", sFile);
+        exit(1);
+    }
+    fputs(sObj, f);
+    fclose(f);
+
+    std::vector<Vec3d> verts;
+    std::vector<int> indices;
+    bool bLoaded = LoadObj(sFile, verts, indices);
+    remove(sFile);
+
+    bool bPass = bLoaded == bExpectLoad && (!bLoaded || indices == vecExpectIndices);
+    printf("%s %s\n", bPass ? "pass" : "FAIL", sName);
+    if (!bPass)
+        nFailures++;
+}
+
+int main()
+{
+    const char* sTriangle = "v 0 0 0\nv 1 0 0\nv 0 1 0\n";
+    std::string s = sTriangle;
+
+    Check("triangle", (s + "f 1 2 3\n").c_str(), true, { 0, 1, 2 });
+    Check("relative indices", (s + "f -3 -2 -1\n").c_str(), true, { 0, 1, 2 });
+    Check("quad split into a fan", "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nf 1 2 3 4\n", true, { 0, 1, 2, 0, 2, 3 });
+    Check("texture and normal parts skipped", (s + "f 1/1/1 2/2/2 3//3\n").c_str(), true, { 0, 1, 2 });
+
+    Check("index zero", (s + "f 0 1 2\n").c_str(), false);
+    Check("index past the vertices", (s + "f 1 2 4\n").c_str(), false);
+    Check("relative index before the first vertex", (s + "f 1 2 -4\n").c_str(), false);
+    Check("index just past INT_MAX", (s + "f 1 2 2147483649\n").c_str(), false);
+    Check("index past 64 bits", (s + "f 1 2 99999999999999999999\n").c_str(), false);
+    Check("relative index just past -INT_MAX", (s + "f 1 2 -2147483649\n").c_str(), false);
+    Check("index at INT_MAX", (s + "f 1 2 2147483647\n").c_str(), false);
+
+    if (nFailures > 0)
+        printf("%d failed\n", nFailures);
+    return nFailures > 0 ? 1 : 0;
+}
@@ -0,0 +1,227 @@
+#pragma once
+
+// Per-stage pipeline timing for olcEngine3D
+//
+// Each frame the pipeline calls PROFILE_LAP(profiler, stage) at the end of
+// every stage it runs, which charges the time since the previous lap to that
+// stage. Stages interleave per triangle, so a lap is just one timestamp read
+// and an add. At the end of the frame the totals are pushed into a fixed ring
+// of frame records that can be read from any thread without locking, which
+// gives rolling p50/p95/p99 per stage. Frames slower than the budget get their
+// whole breakdown dumped.
+//
+// Only enabled where OLC_PROFILE is defined, as the Debug configurations do.
+// Otherwise the macros expand to nothing and the profiler doesn't exist at
+// all, so a plain optimised build times nothing but the frame.
+
+#ifdef OLC_PROFILE
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define OLC_PROFILE_RDTSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define OLC_PROFILE_RDTSC
+#endif
+
+enum PIPELINE_STAGE
+{
+    STAGE_CLEAR,
+    STAGE_CULL,
+    STAGE_BACKFACE,
+    STAGE_LIGHTING,
+    STAGE_TRANSFORM,
+    STAGE_CLIP,
+    STAGE_PROJECTION,
+    STAGE_SORT,
+    STAGE_RASTER,
+    STAGE_COUNT
+};
+
+inline const char* PipelineStageName(int s)
+{
+    static const char* names[STAGE_COUNT] = {
+        "clear", "cull", "backface", "lighting", "transform", "clip", "projection", "sort", "raster"
+    };
+    return names[s];
+}
+
+class PipelineProfiler
+{
+public:
+    struct FrameRecord
+    {
+        uint64_t nFrame;
+        float fFrameMs;
+        float fStageMs[STAGE_COUNT];
+    };
+
+    struct StageStats
+    {
+        float p50, p95, p99;
+    };
+
+    struct Stats
+    {
+        size_t nFrames = 0;
+        StageStats frame = {};
+        StageStats stage[STAGE_COUNT] = {};
+    };
+
+    // Number of frames kept in the ring, and so the rolling window for Stats()
+    static const size_t RING_SIZE = 512;
+
+    // Frames that take longer than this are dumped stage by stage, 0 disables
+    float fBudgetMs = 0.0f;
+
+    // Called with each over-budget frame, defaults to printing it to stderr
+    std::function<void(const FrameRecord&)> onHitch = [](const FrameRecord& r) { Print(stderr, r); };
+
+    void BeginFrame()
+    {
+        for (auto& t : nStageTicks)
+            t = 0;
+        tpFrameStart = std::chrono::steady_clock::now();
+        nFrameStartTick = nLastTick = Ticks();
+    }
+
+    // Charge everything since the last lap (or BeginFrame) to stage s
+    void Lap(int s)
+    {
+        uint64_t t = Ticks();
+        nStageTicks[s] += t - nLastTick;
+        nLastTick = t;
+    }
+
+    // Restart the lap clock without charging any stage, for untracked work
+    void Mark()
+    {
+        nLastTick = Ticks();
+    }
+
+    void EndFrame()
+    {
+        uint64_t nFrameTicks = Ticks() - nFrameStartTick;
+        float fFrameMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - tpFrameStart).count();
+
+        // The tick rate isn't known up front, so scale ticks by this frame's
+        // wall clock time instead of calibrating it
+        float fMsPerTick = nFrameTicks > 0 ? fFrameMs / (float)nFrameTicks : 0.0f;
+
+        uint64_t n = nWritten.load(std::memory_order_relaxed);
+        FrameRecord& r = ring[n % RING_SIZE];
+        r.nFrame = n;
+        r.fFrameMs = fFrameMs;
+        for (int s = 0; s < STAGE_COUNT; s++)
+            r.fStageMs[s] = (float)nStageTicks[s] * fMsPerTick;
+        nWritten.store(n + 1, std::memory_order_release);
+
+        if (fBudgetMs > 0.0f && fFrameMs > fBudgetMs && onHitch)
+            onHitch(r);
+    }
+
+    // Copy out the most recent frames. Only the game thread writes the ring, so
+    // a reader just checks afterwards that none of its slots were overwritten
+    // while it was copying, and drops those that were
+    std::vector<FrameRecord> Recent() const
+    {
+        uint64_t nEnd = nWritten.load(std::memory_order_acquire);
+        uint64_t nStart = nEnd > RING_SIZE ? nEnd - RING_SIZE : 0;
+
+        std::vector<FrameRecord> vecFrames;
+        vecFrames.reserve((size_t)(nEnd - nStart));
+        for (uint64_t n = nStart; n < nEnd; n++)
+            vecFrames.push_back(ring[n % RING_SIZE]);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t nNow = nWritten.load(std::memory_order_relaxed);
+        uint64_t nValidFrom = nNow > RING_SIZE ? nNow - RING_SIZE + 1 : 0;
+        if (nValidFrom > nStart)
+            vecFrames.erase(vecFrames.begin(), vecFrames.begin() + (size_t)std::min<uint64_t>(nValidFrom - nStart, vecFrames.size()));
+        return vecFrames;
+    }
+
+    // Rolling percentiles over the frames currently in the ring
+    Stats GetStats() const
+    {
+        Stats stats;
+        std::vector<FrameRecord> vecFrames = Recent();
+        stats.nFrames = vecFrames.size();
+        if (vecFrames.empty())
+            return stats;
+
+        std::vector<float> vecMs(vecFrames.size());
+        auto percentiles = [&](std::function<float(const FrameRecord&)> get) {
+            for (size_t i = 0; i < vecFrames.size(); i++)
+                vecMs[i] = get(vecFrames[i]);
+            std::sort(vecMs.begin(), vecMs.end());
+            auto at = [&](float p) { return vecMs[(size_t)(p * (float)(vecMs.size() - 1) + 0.5f)]; };
+            return StageStats{ at(0.50f), at(0.95f), at(0.99f) };
+        };
+
+        stats.frame = percentiles([](const FrameRecord& r) { return r.fFrameMs; });
+        for (int s = 0; s < STAGE_COUNT; s++)
+            stats.stage[s] = percentiles([s](const FrameRecord& r) { return r.fStageMs[s]; });
+        return stats;
+    }
+
+    void Report(FILE* f) const
+    {
+        Stats stats = GetStats();
+        fprintf(f, "%-12s %9s %9s %9s   (last %zu frames, ms)\n", "stage", "p50", "p95", "p99", stats.nFrames);
+        for (int s = 0; s < STAGE_COUNT; s++)
+            fprintf(f, "%-12s %9.4f %9.4f %9.4f\n", PipelineStageName(s), stats.stage[s].p50, stats.stage[s].p95, stats.stage[s].p99);
+        fprintf(f, "%-12s %9.4f %9.4f %9.4f\n", "frame", stats.frame.p50, stats.frame.p95, stats.frame.p99);
+    }
+
+    static void Print(FILE* f, const FrameRecord& r)
+    {
+        float fStagesMs = 0.0f;
+        fprintf(f, "HITCH frame %llu: %.3f ms |", (unsigned long long)r.nFrame, r.fFrameMs);
+        for (int s = 0; s < STAGE_COUNT; s++) {
+            fprintf(f, " %s %.3f", PipelineStageName(s), r.fStageMs[s]);
+            fStagesMs += r.fStageMs[s];
+        }
+        fprintf(f, " other %.3f\n", std::max(0.0f, r.fFrameMs - fStagesMs));
+    }
+
+private:
+    static uint64_t Ticks()
+    {
+#ifdef OLC_PROFILE_RDTSC
+        return __rdtsc();
+#else
+        return (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+    }
+
+    uint64_t nStageTicks[STAGE_COUNT] = {};
+    uint64_t nLastTick = 0;
+    uint64_t nFrameStartTick = 0;
+    std::chrono::steady_clock::time_point tpFrameStart;
+
+    FrameRecord ring[RING_SIZE] = {};
+    std::atomic<uint64_t> nWritten{ 0 };
+};
+
+#define PROFILE_BEGIN_FRAME(p)  (p).BeginFrame()
+#define PROFILE_LAP(p, stage)   (p).Lap(stage)
+#define PROFILE_MARK(p)         (p).Mark()
+#define PROFILE_END_FRAME(p)    (p).EndFrame()
+
+#else
+
+#define PROFILE_BEGIN_FRAME(p)  ((void)0)
+#define PROFILE_LAP(p, stage)   ((void)0)
+#define PROFILE_MARK(p)         ((void)0)
+#define PROFILE_END_FRAME(p)    ((void)0)
+
+#endif
@@ -0,0 +1,90 @@
+#pragma once
+
+// Luminance to console cell, as tables worked out at compile time
+//
+// The ramp runs from black to white in 13 shades. Each step between two of
+// the greys covers the darker one, as background, with a quarter, half, three
+// quarters and all of the lighter one as foreground. The four greys and three
+// partial glyphs can't make many more: mixing greys that aren't next to each
+// other adds just one luminance the ramp doesn't have. So a plain cell is one
+// of the 13, and only dithering shows anything finer.
+//
+// A luminance in [0, 1] is turned into an index once per triangle, with
+// SHADE_STEPS steps per shade so that dithering can tell where between two
+// shades it lies, and then looking up its cell is a single load.
+//
+// For ordered dithering every index also has a 4x4 tile of cells, taken from
+// the index nudged by a Bayer threshold, so across a triangle the cells mix
+// its shade and the next one in proportion to how far between them it lies.
+// The rasterizer repeats the tile across the screen, cell (x, y) getting tile
+// entry (y & 3) * 4 + (x & 3), so dithering costs it nothing per cell either.
+// Without dithering a luminance below 1 gets exactly the shade (int)(13 * lum)
+// does, and 1 gets white.
+
+#include "olcConsoleGameEngine.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+constexpr int SHADE_LEVELS = 13;
+constexpr int SHADE_STEPS = 20;    // indices per shade
+constexpr int SHADE_ENTRIES = SHADE_LEVELS * SHADE_STEPS;
+
+constexpr unsigned short SHADE_GLYPHS[4] = { PIXEL_QUARTER, PIXEL_HALF, PIXEL_THREEQUARTERS, PIXEL_SOLID };
+constexpr unsigned short SHADE_COLOURS[3] = { BG_BLACK | FG_DARK_GREY, BG_DARK_GREY | FG_GREY, BG_GREY | FG_WHITE };
+
+constexpr int BAYER_4X4[16] = {
+     0,  8,  2, 10,
+    12,  4, 14,  6,
+     3, 11,  1,  9,
+    15,  7, 13,  5,
+};
+
+constexpr CHAR_INFO Shade_Level(int nLevel)
+{
+    return nLevel == 0
+        ? CHAR_INFO{ { PIXEL_SOLID }, BG_BLACK | FG_BLACK }
+        : CHAR_INFO{ { SHADE_GLYPHS[(nLevel - 1) % 4] }, SHADE_COLOURS[(nLevel - 1) / 4] };
+}
+
+// The index nudged by a threshold from -1/2 to +1/2 of a shade, so dithering
+// leaves a triangle no brighter or darker on average
+constexpr int Shade_Dithered(int nIndex, int nThreshold)
+{
+    return std::min(SHADE_ENTRIES - 1, std::max(0, nIndex + ((2 * nThreshold + 1 - 16) * SHADE_STEPS) / 32));
+}
+
+template <size_t... I>
+constexpr std::array<CHAR_INFO, sizeof...(I)> Shade_BuildCells(std::index_sequence<I...>)
+{
+    return { { Shade_Level((int)I)... } };
+}
+
+template <size_t... I>
+constexpr std::array<CHAR_INFO, sizeof...(I)> Shade_BuildDither(std::index_sequence<I...>)
+{
+    return { { Shade_Level(Shade_Dithered((int)I / 16, BAYER_4X4[I % 16]) / SHADE_STEPS)... } };
+}
+
+inline constexpr std::array<CHAR_INFO, SHADE_LEVELS> SHADE_CELLS = Shade_BuildCells(std::make_index_sequence<SHADE_LEVELS>());
+inline constexpr std::array<CHAR_INFO, SHADE_ENTRIES * 16> SHADE_DITHER = Shade_BuildDither(std::make_index_sequence<SHADE_ENTRIES * 16>());
+
+// Index of a luminance in [0, 1]; anything outside is clamped to it
+inline uint16_t Shade_Index(float fLum)
+{
+    return (uint16_t)std::min(SHADE_ENTRIES - 1, std::max(0, (int)(fLum * (float)SHADE_ENTRIES)));
+}
+
+inline CHAR_INFO Shade_Cell(uint16_t nIndex)
+{
+    return SHADE_CELLS[nIndex / SHADE_STEPS];
+}
+
+// The 4x4 tile of cells to dither the shade with
+inline const CHAR_INFO* Shade_Dither(uint16_t nIndex)
+{
+    return SHADE_DITHER.data() + nIndex * 16;
+}
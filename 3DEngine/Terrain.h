@@ -0,0 +1,461 @@
+#pragma once
+
+// Chunked level of detail for terrain
+//
+// The terrain, a surface over x and z with y up, is cut into a quadtree of
+// square chunks. The leaves hold the mesh's own triangles, and every node
+// above them a simplified mesh of its whole square with about as many
+// triangles as a leaf: the vertices are clustered on a TERRAIN_GRID square
+// grid over the node, each cluster moved to the average of its vertices, and
+// the triangles that collapse dropped. So each level up covers four times the
+// ground with the same number of triangles.
+//
+// Each node knows its geometric error, the furthest its surface is from the
+// full detail one. Terrain_Select walks down from the root and stops at the
+// first node whose error, projected to the screen from its nearest point to
+// the eye, is small enough, so distant ground comes from a few big coarse
+// nodes and the triangles drawn stay about the same however large the
+// terrain gets.
+//
+// Neighbours at the same level share clusters and so border vertices, but
+// neighbours at different levels don't, which would leave cracks between
+// them. Every node has a skirt hanging down from its border edges to cover
+// them, as deep as twice its parent's error - the furthest apart the two
+// borders can be when the neighbour is up to a level coarser - and draws it
+// only when a neighbour in view is drawn at a different level. That only
+// holds if neighbours are never more than a level apart, so after choosing
+// nodes by their error Terrain_Select splits any node with a neighbour two or
+// more levels finer until none has.
+//
+// As in the BVH, every node has its own copy of the vertices it uses, so each
+// node's triangles and vertices are one run each.
+
+#include "Geometry3D.h"
+#include "Clipper.h"
+#include "Bvh.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+#include <vector>
+
+static const int TERRAIN_GRID = 16;         // clusters along each side of a node
+static const int TERRAIN_MAX_DEPTH = 8;
+
+// Nodes are stored depth first, so everything under a node comes after it
+struct TerrainNode {
+    float fMin[3];
+    float fMax[3];                      // around the node and everything under it
+    float fError;                       // at most this far from the full detail surface
+    uint32_t nFirstTri, nTriCount;      // the node's own triangles, not its children's
+    uint32_t nFirstVert, nVertCount;    // and vertices
+    uint32_t nSkirtTris, nSkirtVerts;   // how many of those, at the end, are the skirt
+    uint32_t nChild[4];                 // 0 where there's none, the root is node 0
+    uint16_t nDepth, nX, nZ;            // its square, of 2^nDepth by 2^nDepth over the terrain
+    uint16_t nPad;
+};
+
+// Every triangle of the terrain simplified for the nodes at one depth, as
+// three vertex ids each, grouped by node
+struct TerrainLevel {
+    std::vector<Vec3d> vecPos;          // position of each vertex id
+    std::vector<float> vecError;        // and how far it is from the vertices it stands for
+    std::vector<uint32_t> vecTris;
+    std::vector<uint32_t> vecNodeStart; // node k's triangles are [start[k], start[k + 1])
+    std::vector<uint64_t> vecEdges;     // each edge of each triangle, sorted
+    std::vector<float> vecNodeError;    // the node and everything under it
+    std::vector<uint8_t> vecNodeUsed;   // whether any of the mesh's triangles are in the node
+};
+
+inline uint64_t Terrain_EdgeKey(uint32_t a, uint32_t b)
+{
+    return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+}
+
+// Build the quadtree over a terrain mesh into verts, indices and nodes
+inline void Terrain_Build(const Vec3d* pVerts, size_t nVerts, const int* pIndices, size_t nTris,
+    std::vector<Vec3d>& verts, std::vector<int>& indices, std::vector<TerrainNode>& nodes)
+{
+    verts.clear();
+    indices.clear();
+    nodes.clear();
+    if (nTris == 0)
+        return;
+
+    float fMinX = FLT_MAX, fMinZ = FLT_MAX, fMaxX = -FLT_MAX, fMaxZ = -FLT_MAX;
+    for (size_t v = 0; v < nVerts; v++) {
+        fMinX = std::min(fMinX, pVerts[v].x); fMaxX = std::max(fMaxX, pVerts[v].x);
+        fMinZ = std::min(fMinZ, pVerts[v].z); fMaxZ = std::max(fMaxZ, pVerts[v].z);
+    }
+    float fSize = std::max(std::max(fMaxX - fMinX, fMaxZ - fMinZ), 1e-6f);
+
+    // Deep enough that a leaf holds about as many triangles as a full grid
+    int nDepth = 0;
+    while (nDepth < TERRAIN_MAX_DEPTH && (nTris >> (2 * nDepth)) > (size_t)(2 * TERRAIN_GRID * TERRAIN_GRID))
+        nDepth++;
+
+    // Which cell of an n x n grid over the terrain a point is in
+    auto cell = [&](float f, float fMin, int n) {
+        return std::min(std::max((int)((f - fMin) / fSize * (float)n), 0), n - 1);
+    };
+
+    // Triangles belong to the leaf their centre is in, and so to that leaf's
+    // ancestors at every other depth
+    int nLeafSide = 1 << nDepth;
+    std::vector<uint32_t> vecLeafX(nTris), vecLeafZ(nTris);
+    for (size_t t = 0; t < nTris; t++) {
+        const Vec3d& a = pVerts[pIndices[t * 3]];
+        const Vec3d& b = pVerts[pIndices[t * 3 + 1]];
+        const Vec3d& c = pVerts[pIndices[t * 3 + 2]];
+        vecLeafX[t] = cell((a.x + b.x + c.x) / 3.0f, fMinX, nLeafSide);
+        vecLeafZ[t] = cell((a.z + b.z + c.z) / 3.0f, fMinZ, nLeafSide);
+    }
+
+    std::vector<TerrainLevel> levels(nDepth + 1);
+    std::vector<uint32_t> vecVertId(nVerts);
+    for (int d = 0; d <= nDepth; d++) {
+        TerrainLevel& lv = levels[d];
+        int nSide = 1 << d;
+        size_t nNodes = (size_t)nSide * nSide;
+
+        if (d == nDepth) {
+            lv.vecPos.assign(pVerts, pVerts + nVerts);
+            lv.vecError.assign(nVerts, 0.0f);
+            for (size_t v = 0; v < nVerts; v++)
+                vecVertId[v] = (uint32_t)v;
+        }
+        else {
+            // Cluster on a grid TERRAIN_GRID cells across each node
+            int nCells = TERRAIN_GRID * nSide;
+            std::vector<double> vecSum((size_t)nCells * nCells * 3, 0.0);
+            std::vector<uint32_t> vecCount((size_t)nCells * nCells, 0);
+            for (size_t v = 0; v < nVerts; v++) {
+                uint32_t c = (uint32_t)(cell(pVerts[v].z, fMinZ, nCells) * nCells + cell(pVerts[v].x, fMinX, nCells));
+                vecVertId[v] = c;
+                vecSum[c * 3] += pVerts[v].x;
+                vecSum[c * 3 + 1] += pVerts[v].y;
+                vecSum[c * 3 + 2] += pVerts[v].z;
+                vecCount[c]++;
+            }
+
+            lv.vecPos.resize(vecCount.size());
+            lv.vecError.assign(vecCount.size(), 0.0f);
+            for (size_t c = 0; c < vecCount.size(); c++)
+                if (vecCount[c] > 0)
+                    lv.vecPos[c] = { (float)(vecSum[c * 3] / vecCount[c]), (float)(vecSum[c * 3 + 1] / vecCount[c]), (float)(vecSum[c * 3 + 2] / vecCount[c]) };
+            for (size_t v = 0; v < nVerts; v++) {
+                const Vec3d& p = pVerts[v];
+                const Vec3d& q = lv.vecPos[vecVertId[v]];
+                float fDist = sqrtf((p.x - q.x) * (p.x - q.x) + (p.y - q.y) * (p.y - q.y) + (p.z - q.z) * (p.z - q.z));
+                lv.vecError[vecVertId[v]] = std::max(lv.vecError[vecVertId[v]], fDist);
+            }
+        }
+
+        // Simplified triangles, each turned to start at its lowest id so that
+        // two which collapsed onto the same one are equal, then sorted by node
+        struct Tri { uint32_t nNode, a, b, c; };
+        std::vector<Tri> vecTris;
+        vecTris.reserve(nTris);
+        lv.vecNodeUsed.assign(nNodes, 0);
+        int nShift = nDepth - d;
+        for (size_t t = 0; t < nTris; t++) {
+            uint32_t nNode = (vecLeafZ[t] >> nShift) * nSide + (vecLeafX[t] >> nShift);
+            lv.vecNodeUsed[nNode] = 1;
+
+            uint32_t a = vecVertId[pIndices[t * 3]], b = vecVertId[pIndices[t * 3 + 1]], c = vecVertId[pIndices[t * 3 + 2]];
+            if (a == b || b == c || c == a)
+                continue;
+            if (b < a && b < c)
+                vecTris.push_back({ nNode, b, c, a });
+            else if (c < a && c < b)
+                vecTris.push_back({ nNode, c, a, b });
+            else
+                vecTris.push_back({ nNode, a, b, c });
+        }
+        auto key = [](const Tri& t) { return std::make_tuple(t.nNode, t.a, t.b, t.c); };
+        std::sort(vecTris.begin(), vecTris.end(), [&](const Tri& x, const Tri& y) { return key(x) < key(y); });
+        vecTris.erase(std::unique(vecTris.begin(), vecTris.end(), [&](const Tri& x, const Tri& y) { return key(x) == key(y); }), vecTris.end());
+
+        lv.vecNodeStart.assign(nNodes + 1, 0);
+        lv.vecNodeError.assign(nNodes, 0.0f);
+        lv.vecTris.reserve(vecTris.size() * 3);
+        lv.vecEdges.reserve(vecTris.size() * 3);
+        for (const Tri& t : vecTris) {
+            lv.vecNodeStart[t.nNode + 1]++;
+            lv.vecTris.insert(lv.vecTris.end(), { t.a, t.b, t.c });
+            lv.vecEdges.insert(lv.vecEdges.end(), { Terrain_EdgeKey(t.a, t.b), Terrain_EdgeKey(t.b, t.c), Terrain_EdgeKey(t.c, t.a) });
+            float fError = std::max(std::max(lv.vecError[t.a], lv.vecError[t.b]), lv.vecError[t.c]);
+            lv.vecNodeError[t.nNode] = std::max(lv.vecNodeError[t.nNode], fError);
+        }
+        for (size_t n = 0; n < nNodes; n++)
+            lv.vecNodeStart[n + 1] += lv.vecNodeStart[n];
+        std::sort(lv.vecEdges.begin(), lv.vecEdges.end());
+    }
+
+    // A node's error covers its children's, so the error only ever shrinks on
+    // the way down and Terrain_Select can stop at the first node that's fine
+    for (int d = nDepth - 1; d >= 0; d--) {
+        int nSide = 1 << d;
+        for (int z = 0; z < nSide; z++)
+            for (int x = 0; x < nSide; x++)
+                for (int k = 0; k < 4; k++) {
+                    uint32_t nChild = (uint32_t)((z * 2 + (k >> 1)) * nSide * 2 + x * 2 + (k & 1));
+                    float& fError = levels[d].vecNodeError[z * nSide + x];
+                    fError = std::max(fError, levels[d + 1].vecNodeError[nChild]);
+                }
+    }
+
+    // Lay the nodes out depth first, each with its own vertices and skirt
+    // Stamped with the node that last copied each vertex id, which is
+    // different for every node so they never need clearing
+    size_t nIds = 0;
+    for (const TerrainLevel& lv : levels)
+        nIds = std::max(nIds, lv.vecPos.size());
+    std::vector<uint32_t> vecStamp(nIds, UINT32_MAX), vecLocal(nIds), vecSkirtStamp(nIds, UINT32_MAX), vecSkirtLocal(nIds);
+    std::vector<uint64_t> vecNodeEdges;
+    struct Entry { int nDepth; uint32_t x, z, nParent, nSlot; };
+    std::vector<Entry> stack = { { 0, 0, 0, UINT32_MAX, 0 } };
+    while (!stack.empty()) {
+        Entry e = stack.back();
+        stack.pop_back();
+        const TerrainLevel& lv = levels[e.nDepth];
+        uint32_t nKey = e.z * (1u << e.nDepth) + e.x;
+
+        uint32_t n = (uint32_t)nodes.size();
+        nodes.push_back({});
+        if (e.nParent != UINT32_MAX)
+            nodes[e.nParent].nChild[e.nSlot] = n;
+
+        TerrainNode& node = nodes[n];
+        node.nDepth = (uint16_t)e.nDepth;
+        node.nX = (uint16_t)e.x;
+        node.nZ = (uint16_t)e.z;
+        node.fError = lv.vecNodeError[nKey];
+        node.nFirstTri = (uint32_t)(indices.size() / 3);
+        node.nFirstVert = (uint32_t)verts.size();
+
+        auto local = [&](uint32_t id) {
+            if (vecStamp[id] != n) {
+                vecStamp[id] = n;
+                vecLocal[id] = (uint32_t)verts.size();
+                verts.push_back(lv.vecPos[id]);
+            }
+            return (int)vecLocal[id];
+        };
+
+        const uint32_t* pFirst = lv.vecTris.data() + lv.vecNodeStart[nKey] * 3;
+        const uint32_t* pLast = lv.vecTris.data() + lv.vecNodeStart[nKey + 1] * 3;
+        for (const uint32_t* p = pFirst; p < pLast; p++)
+            indices.push_back(local(*p));
+        uint32_t nSurfaceTris = (uint32_t)(indices.size() / 3) - node.nFirstTri;
+        uint32_t nSurfaceVerts = (uint32_t)verts.size() - node.nFirstVert;
+
+        // Skirt the edges this node's triangles use once that other nodes'
+        // triangles use too. Each goes straight down, wound so its front
+        // faces the same way as the triangle it hangs from
+        float fSkirt = e.nDepth > 0 ? 2.0f * levels[e.nDepth - 1].vecNodeError[(e.z >> 1) * (1u << (e.nDepth - 1)) + (e.x >> 1)] : 0.0f;
+        if (fSkirt > 0.0f) {
+            vecNodeEdges.clear();
+            for (const uint32_t* p = pFirst; p < pLast; p += 3)
+                vecNodeEdges.insert(vecNodeEdges.end(), { Terrain_EdgeKey(p[0], p[1]), Terrain_EdgeKey(p[1], p[2]), Terrain_EdgeKey(p[2], p[0]) });
+            std::sort(vecNodeEdges.begin(), vecNodeEdges.end());
+
+            auto lowered = [&](uint32_t id) {
+                if (vecSkirtStamp[id] != n) {
+                    vecSkirtStamp[id] = n;
+                    vecSkirtLocal[id] = (uint32_t)verts.size();
+                    Vec3d p = lv.vecPos[id];
+                    p.y -= fSkirt;
+                    verts.push_back(p);
+                }
+                return (int)vecSkirtLocal[id];
+            };
+
+            for (const uint32_t* p = pFirst; p < pLast; p += 3) {
+                for (int k = 0; k < 3; k++) {
+                    uint32_t a = p[k], b = p[(k + 1) % 3];
+                    uint64_t nEdge = Terrain_EdgeKey(a, b);
+                    auto mine = std::equal_range(vecNodeEdges.begin(), vecNodeEdges.end(), nEdge);
+                    auto all = std::equal_range(lv.vecEdges.begin(), lv.vecEdges.end(), nEdge);
+                    if (mine.second - mine.first != 1 || all.second - all.first < 2)
+                        continue;
+                    indices.insert(indices.end(), { local(b), local(a), lowered(a) });
+                    indices.insert(indices.end(), { local(b), lowered(a), lowered(b) });
+                }
+            }
+        }
+
+        node.nTriCount = (uint32_t)(indices.size() / 3) - node.nFirstTri;
+        node.nVertCount = (uint32_t)verts.size() - node.nFirstVert;
+        node.nSkirtTris = node.nTriCount - nSurfaceTris;
+        node.nSkirtVerts = node.nVertCount - nSurfaceVerts;
+        node.fMin[0] = node.fMin[1] = node.fMin[2] = FLT_MAX;
+        node.fMax[0] = node.fMax[1] = node.fMax[2] = -FLT_MAX;
+        for (uint32_t v = node.nFirstVert; v < node.nFirstVert + node.nVertCount; v++) {
+            const Vec3d& p = verts[v];
+            node.fMin[0] = std::min(node.fMin[0], p.x); node.fMax[0] = std::max(node.fMax[0], p.x);
+            node.fMin[1] = std::min(node.fMin[1], p.y); node.fMax[1] = std::max(node.fMax[1], p.y);
+            node.fMin[2] = std::min(node.fMin[2], p.z); node.fMax[2] = std::max(node.fMax[2], p.z);
+        }
+
+        // Children last to first, so the first comes off the stack first
+        if (e.nDepth < nDepth) {
+            const TerrainLevel& child = levels[e.nDepth + 1];
+            for (int k = 3; k >= 0; k--) {
+                uint32_t x = e.x * 2 + (k & 1), z = e.z * 2 + (k >> 1);
+                if (child.vecNodeUsed[z * (2u << e.nDepth) + x])
+                    stack.push_back({ e.nDepth + 1, x, z, n, (uint32_t)k });
+            }
+        }
+    }
+
+    // Boxes cover everything under them, which comes after them
+    for (size_t n = nodes.size(); n-- > 0;) {
+        TerrainNode& node = nodes[n];
+        for (uint32_t nChild : node.nChild) {
+            if (nChild == 0)
+                continue;
+            for (int k = 0; k < 3; k++) {
+                node.fMin[k] = std::min(node.fMin[k], nodes[nChild].fMin[k]);
+                node.fMax[k] = std::max(node.fMax[k], nodes[nChild].fMax[k]);
+            }
+        }
+    }
+}
+
+// Every leaf is at the same depth, the last node's, and Terrain_Select needs
+// a byte for each leaf's square
+inline size_t Terrain_GridCells(const TerrainNode* pNodes, size_t nNodes)
+{
+    return nNodes == 0 ? 0 : (size_t)1 << (2 * pNodes[nNodes - 1].nDepth);
+}
+
+// Pick the nodes to draw: the first on the way down from the root whose error
+// is no more than fMaxError screen cells from its nearest point to vEye, where
+// a unit at distance 1 covers fPixelsPerUnit cells, and that aren't wholly
+// outside the planes. Everything is in the terrain's own space, the planes
+// a*x + b*y + c*z + d >= 0 inside. Nodes next to each other are then split
+// until they're at most one level apart. Their runs go to pTris and pVerts, which
+// need room for Bvh_MaxRanges over all the nodes. pDrawn needs room for a
+// node each and pGrid for Terrain_GridCells
+inline void Terrain_Select(const TerrainNode* pNodes, size_t nNodes, const ClipPlane* pPlanes, int nPlanes,
+    const Vec3d& vEye, float fPixelsPerUnit, float fMaxError, uint32_t* pDrawn, uint8_t* pGrid,
+    BvhRange* pTris, size_t& nTriRanges, uint32_t nMaxTris, BvhRange* pVerts, size_t& nVertRanges, uint32_t nMaxVerts)
+{
+    nTriRanges = nVertRanges = 0;
+    if (nNodes == 0)
+        return;
+
+    // The depth of the node drawn over each leaf's square, if any
+    static const uint8_t NOT_DRAWN = 0xff;
+    int nLeafDepth = pNodes[nNodes - 1].nDepth;
+    int nGridSide = 1 << nLeafDepth;
+    memset(pGrid, NOT_DRAWN, Terrain_GridCells(pNodes, nNodes));
+    size_t nDrawn = 0;
+
+    // Each node pushes at most four, so the stack never holds more than
+    // three per level plus the four of the last
+    struct Entry { uint32_t nNode, nPlaneMask; };
+    Entry stack[3 * TERRAIN_MAX_DEPTH + 4];
+    int nStack = 0;
+    stack[nStack++] = { 0, (1u << nPlanes) - 1 };
+
+    float fEye[3] = { vEye.x, vEye.y, vEye.z };
+    while (nStack > 0) {
+        Entry e = stack[--nStack];
+        const TerrainNode& node = pNodes[e.nNode];
+
+        if (!Bvh_TestBox(node.fMin, node.fMax, pPlanes, nPlanes, e.nPlaneMask))
+            continue;
+
+        float fDistSq = 0.0f;
+        for (int k = 0; k < 3; k++) {
+            float f = std::max(std::max(node.fMin[k] - fEye[k], fEye[k] - node.fMax[k]), 0.0f);
+            fDistSq += f * f;
+        }
+
+        // fError * fPixelsPerUnit / fDist <= fMaxError, without the divide
+        float fProjected = node.fError * fPixelsPerUnit;
+        bool bLeaf = (node.nChild[0] | node.nChild[1] | node.nChild[2] | node.nChild[3]) == 0;
+        if (bLeaf || fProjected * fProjected <= fMaxError * fMaxError * fDistSq) {
+            pDrawn[nDrawn++] = e.nNode;
+            int nSize = 1 << (nLeafDepth - node.nDepth);
+            for (int z = node.nZ * nSize; z < (node.nZ + 1) * nSize; z++)
+                memset(pGrid + z * nGridSide + node.nX * nSize, node.nDepth, nSize);
+            continue;
+        }
+
+        for (int k = 3; k >= 0; k--)
+            if (node.nChild[k] != 0)
+                stack[nStack++] = { node.nChild[k], e.nPlaneMask };
+    }
+
+    // Whether any neighbour of the node drawn along its border satisfies f,
+    // given the depth drawn there. A neighbour that isn't drawn is out of
+    // view, and so is the border
+    auto anyNeighbour = [&](const TerrainNode& node, auto f) {
+        int nSize = 1 << (nLeafDepth - node.nDepth);
+        int x0 = node.nX * nSize, z0 = node.nZ * nSize;
+        auto test = [&](int x, int z) {
+            if (x < 0 || z < 0 || x >= nGridSide || z >= nGridSide)
+                return false;
+            uint8_t d = pGrid[z * nGridSide + x];
+            return d != NOT_DRAWN && f((int)d);
+        };
+        for (int k = 0; k < nSize; k++)
+            if (test(x0 - 1, z0 + k) || test(x0 + nSize, z0 + k) || test(x0 + k, z0 - 1) || test(x0 + k, z0 + nSize))
+                return true;
+        return false;
+    };
+
+    // Split nodes with a neighbour more than a level finer into the children
+    // in view, until there are none. A split only ever makes neighbours finer,
+    // so this ends, at the latest with everything in view at the leaves
+    for (bool bSplit = true; bSplit;) {
+        bSplit = false;
+        for (size_t i = 0; i < nDrawn;) {
+            const TerrainNode& node = pNodes[pDrawn[i]];
+            bool bLeaf = (node.nChild[0] | node.nChild[1] | node.nChild[2] | node.nChild[3]) == 0;
+            if (bLeaf || !anyNeighbour(node, [&](int d) { return d > node.nDepth + 1; })) {
+                i++;
+                continue;
+            }
+
+            int nSize = 1 << (nLeafDepth - node.nDepth);
+            for (int z = node.nZ * nSize; z < (node.nZ + 1) * nSize; z++)
+                memset(pGrid + z * nGridSide + node.nX * nSize, NOT_DRAWN, nSize);
+            pDrawn[i] = pDrawn[--nDrawn];
+            for (uint32_t nChild : node.nChild) {
+                const TerrainNode& child = pNodes[nChild];
+                uint32_t nPlaneMask = (1u << nPlanes) - 1;
+                if (nChild == 0 || !Bvh_TestBox(child.fMin, child.fMax, pPlanes, nPlanes, nPlaneMask))
+                    continue;
+                pDrawn[nDrawn++] = nChild;
+                int nChildSize = nSize / 2;
+                for (int z = child.nZ * nChildSize; z < (child.nZ + 1) * nChildSize; z++)
+                    memset(pGrid + z * nGridSide + child.nX * nChildSize, child.nDepth, nChildSize);
+            }
+            bSplit = true;
+        }
+    }
+
+    // Nodes are laid out in the order the walk down visits them, so that's the
+    // order they're drawn in whether or not any were split
+    std::sort(pDrawn, pDrawn + nDrawn);
+
+    // Skirts are only needed against neighbours drawn at another depth
+    for (size_t i = 0; i < nDrawn; i++) {
+        const TerrainNode& node = pNodes[pDrawn[i]];
+        assert(!anyNeighbour(node, [&](int d) { return std::abs(d - node.nDepth) > 1; }));
+        bool bSkirt = anyNeighbour(node, [&](int d) { return d != node.nDepth; });
+
+        uint32_t nTris = bSkirt ? node.nTriCount : node.nTriCount - node.nSkirtTris;
+        uint32_t nVerts = bSkirt ? node.nVertCount : node.nVertCount - node.nSkirtVerts;
+        Bvh_AddRange(pTris, nTriRanges, node.nFirstTri, node.nFirstTri + nTris, nMaxTris);
+        Bvh_AddRange(pVerts, nVertRanges, node.nFirstVert, node.nFirstVert + nVerts, nMaxVerts);
+    }
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+// Screen tiles for parallel rasterization
+//
+// The screen is cut into square tiles and each triangle's id is added to the
+// bin of every tile its bounding box touches, in submission order. The bins
+// are laid out back to back in one block the caller provides, e.g. from the
+// frame arena. A tile is
+// then drawn by one thread, clipped to the tile, going through its bin front
+// to back - so no two threads ever write the same cell, and every cell sees
+// the same triangles in the same order as drawing the whole list on one thread.
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+class TileBins {
+public:
+    // The ids of one tile's bin, in the order they were added
+    struct Span {
+        const uint32_t* pFirst;
+        const uint32_t* pLast;
+        const uint32_t* begin() const { return pFirst; }
+        const uint32_t* end() const { return pLast; }
+    };
+
+    // Cut a width x height screen into tiles of nSize cells, the ones along
+    // the right and bottom edges may be smaller. Empties the bins
+    void Resize(int width, int height, int nSize) {
+        nWidth = width;
+        nHeight = height;
+        nTileSize = nSize;
+        nTilesX = (width + nSize - 1) / nSize;
+        nTilesY = (height + nSize - 1) / nSize;
+        vecStart.assign((size_t)nTilesX * nTilesY + 1, 0);
+        vecNext.assign((size_t)nTilesX * nTilesY, 0);
+        nTotal = 0;
+        pIds = nullptr;
+    }
+
+    // The bins are filled in two passes over the same triangles, so they all
+    // fit in one block of ids with no bin growing on its own. First Count
+    // every triangle's cells, then Place the bins in a block of Total() ids,
+    // then Add every triangle again in the same order
+
+    // Count a triangle overlapping the cells [minx, maxx] x [miny, maxy],
+    // which may run off the screen
+    void Count(int minx, int miny, int maxx, int maxy) {
+        ForTiles(minx, miny, maxx, maxy, [&](size_t t) { vecStart[t + 1]++; nTotal++; });
+    }
+
+    size_t Total() const { return nTotal; }
+
+    // Lay the bins out one after another in pBlock, which holds Total() ids
+    void Place(uint32_t* pBlock) {
+        pIds = pBlock;
+        for (size_t t = 1; t < vecStart.size(); t++)
+            vecStart[t] += vecStart[t - 1];
+        for (size_t t = 0; t < vecNext.size(); t++)
+            vecNext[t] = vecStart[t];
+    }
+
+    // Add triangle id to every tile overlapping its cells, as counted
+    void Add(uint32_t id, int minx, int miny, int maxx, int maxy) {
+        ForTiles(minx, miny, maxx, maxy, [&](size_t t) { pIds[vecNext[t]++] = id; });
+    }
+
+    int Count() const { return nTilesX * nTilesY; }
+    int TileSize() const { return nTileSize; }
+    Span Bin(int t) const { return { pIds + vecStart[t], pIds + vecStart[t + 1] }; }
+
+    // The cells of tile t, [x1, x2) x [y1, y2)
+    void Rect(int t, int& x1, int& y1, int& x2, int& y2) const {
+        x1 = (t % nTilesX) * nTileSize;
+        y1 = (t / nTilesX) * nTileSize;
+        x2 = std::min(x1 + nTileSize, nWidth);
+        y2 = std::min(y1 + nTileSize, nHeight);
+    }
+
+private:
+    template <typename F>
+    void ForTiles(int minx, int miny, int maxx, int maxy, F f) {
+        if (maxx < 0 || maxy < 0)
+            return;
+        int tx1 = std::max(minx, 0) / nTileSize, tx2 = std::min(maxx, nWidth - 1) / nTileSize;
+        int ty1 = std::max(miny, 0) / nTileSize, ty2 = std::min(maxy, nHeight - 1) / nTileSize;
+        for (int ty = ty1; ty <= ty2; ty++)
+            for (int tx = tx1; tx <= tx2; tx++)
+                f((size_t)ty * nTilesX + tx);
+    }
+
+    int nWidth = 0;
+    int nHeight = 0;
+    int nTileSize = 32;
+    int nTilesX = 0;
+    int nTilesY = 0;
+    std::vector<size_t> vecStart;   // where each bin starts in pIds, one past the end at the back
+    std::vector<size_t> vecNext;    // where Add puts each bin's next id
+    size_t nTotal = 0;
+    uint32_t* pIds = nullptr;
+};
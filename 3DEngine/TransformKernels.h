@@ -0,0 +1,239 @@
+#pragma once
+
+// Batch vertex transforms
+//
+// Transforms whole arrays of vertices by a Mat4x4, stored as separate x, y, z
+// and w streams (structure of arrays) so that a SIMD register holds the same
+// component of 4, 8 or 16 vertices and each row of the matrix is a broadcast.
+// There are SSE2, AVX2 and AVX-512 kernels plus a plain scalar one, and the
+// best one the CPU supports is picked the first time a transform runs.
+//
+// Every kernel does exactly the same multiplies and adds in the same order as
+// Matrix_MultiplyVector - x*m0 + y*m1 + z*m2 + w*m3, no fused multiply-adds -
+// so they all give bit-identical results and switching between them never
+// changes a rendered frame.
+
+#include "Geometry3D.h"
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+// GCC contracts a separate multiply and add into an FMA whenever the target
+// has one, e.g. the AVX kernels or anything built with -march=native, which
+// would break the bit-exactness above. So every kernel, the scalar one too,
+// and Matrix_MultiplyVector turn it off
+#ifdef _MSC_VER
+#define OLC_NO_CONTRACT
+#else
+#define OLC_NO_CONTRACT __attribute__((optimize("fp-contract=off")))
+#endif
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define OLC_TRANSFORM_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define OLC_TARGET(s)
+#else
+#define OLC_TARGET(s) __attribute__((target(s), optimize("fp-contract=off")))
+#endif
+#endif
+
+// Vertices as four parallel component arrays
+struct VertexStreams {
+    std::vector<float> x, y, z, w;
+
+    size_t size() const { return x.size(); }
+
+    void resize(size_t n) {
+        x.resize(n);
+        y.resize(n);
+        z.resize(n);
+        w.resize(n);
+    }
+
+    void Set(size_t i, const Vec3d& v) {
+        x[i] = v.x;
+        y[i] = v.y;
+        z[i] = v.z;
+        w[i] = v.w;
+    }
+
+    Vec3d Get(size_t i) const {
+        return { x[i], y[i], z[i], w[i] };
+    }
+};
+
+// out = in * m for n vertices. out may be the same streams as in
+typedef void (*TransformKernel)(const Mat4x4& m, const float* ix, const float* iy, const float* iz, const float* iw,
+    float* ox, float* oy, float* oz, float* ow, size_t n);
+
+OLC_NO_CONTRACT
+inline void Transform_Scalar(const Mat4x4& m, const float* ix, const float* iy, const float* iz, const float* iw,
+    float* ox, float* oy, float* oz, float* ow, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        float x = ix[i], y = iy[i], z = iz[i], w = iw[i];
+        ox[i] = x * m.m[0][0] + y * m.m[1][0] + z * m.m[2][0] + w * m.m[3][0];
+        oy[i] = x * m.m[0][1] + y * m.m[1][1] + z * m.m[2][1] + w * m.m[3][1];
+        oz[i] = x * m.m[0][2] + y * m.m[1][2] + z * m.m[2][2] + w * m.m[3][2];
+        ow[i] = x * m.m[0][3] + y * m.m[1][3] + z * m.m[2][3] + w * m.m[3][3];
+    }
+}
+
+#ifdef OLC_TRANSFORM_X86
+
+// The three SIMD kernels are the same loop at different widths: broadcast the
+// sixteen matrix entries once, then each output component is four multiplies
+// summed left to right. Whatever doesn't fill a register goes through the
+// scalar kernel.
+#define OLC_TRANSFORM_KERNEL(WIDTH, REG, SET1, LOAD, STORE, MUL, ADD)                              \
+    REG c[4][4];                                                                                   \
+    for (int r = 0; r < 4; r++)                                                                    \
+        for (int k = 0; k < 4; k++)                                                                \
+            c[r][k] = SET1(m.m[r][k]);                                                             \
+                                                                                                   \
+    size_t i = 0;                                                                                  \
+    for (; i + WIDTH <= n; i += WIDTH) {                                                           \
+        REG x = LOAD(ix + i), y = LOAD(iy + i), z = LOAD(iz + i), w = LOAD(iw + i);                \
+        REG rx = ADD(ADD(ADD(MUL(x, c[0][0]), MUL(y, c[1][0])), MUL(z, c[2][0])), MUL(w, c[3][0])); \
+        REG ry = ADD(ADD(ADD(MUL(x, c[0][1]), MUL(y, c[1][1])), MUL(z, c[2][1])), MUL(w, c[3][1])); \
+        REG rz = ADD(ADD(ADD(MUL(x, c[0][2]), MUL(y, c[1][2])), MUL(z, c[2][2])), MUL(w, c[3][2])); \
+        REG rw = ADD(ADD(ADD(MUL(x, c[0][3]), MUL(y, c[1][3])), MUL(z, c[2][3])), MUL(w, c[3][3])); \
+        STORE(ox + i, rx);                                                                         \
+        STORE(oy + i, ry);                                                                         \
+        STORE(oz + i, rz);                                                                         \
+        STORE(ow + i, rw);                                                                         \
+    }                                                                                              \
+    Transform_Scalar(m, ix + i, iy + i, iz + i, iw + i, ox + i, oy + i, oz + i, ow + i, n - i);
+
+OLC_TARGET("sse2")
+inline void Transform_SSE2(const Mat4x4& m, const float* ix, const float* iy, const float* iz, const float* iw,
+    float* ox, float* oy, float* oz, float* ow, size_t n)
+{
+    OLC_TRANSFORM_KERNEL(4, __m128, _mm_set1_ps, _mm_loadu_ps, _mm_storeu_ps, _mm_mul_ps, _mm_add_ps)
+}
+
+OLC_TARGET("avx2")
+inline void Transform_AVX2(const Mat4x4& m, const float* ix, const float* iy, const float* iz, const float* iw,
+    float* ox, float* oy, float* oz, float* ow, size_t n)
+{
+    OLC_TRANSFORM_KERNEL(8, __m256, _mm256_set1_ps, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_mul_ps, _mm256_add_ps)
+}
+
+OLC_TARGET("avx512f")
+inline void Transform_AVX512(const Mat4x4& m, const float* ix, const float* iy, const float* iz, const float* iw,
+    float* ox, float* oy, float* oz, float* ow, size_t n)
+{
+    OLC_TRANSFORM_KERNEL(16, __m512, _mm512_set1_ps, _mm512_loadu_ps, _mm512_storeu_ps, _mm512_mul_ps, _mm512_add_ps)
+}
+
+#undef OLC_TRANSFORM_KERNEL
+
+enum CPU_FEATURE
+{
+    CPU_SSE2    = 1,
+    CPU_AVX2    = 2,
+    CPU_AVX512F = 4,
+};
+
+// What the CPU and OS together support. AVX needs the OS to save the wider
+// registers on a context switch, which is what the XGETBV checks are for
+inline int Cpu_Features()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    int nMaxLeaf = info[0];
+
+    __cpuid(info, 1);
+    int nFeatures = (info[3] & (1 << 26)) ? CPU_SSE2 : 0;
+    bool bOsAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 0x06) == 0x06;
+    if (!bOsAvx || nMaxLeaf < 7)
+        return nFeatures;
+
+    bool bOsAvx512 = (_xgetbv(0) & 0xe6) == 0xe6;
+    __cpuidex(info, 7, 0);
+    if (info[1] & (1 << 5))
+        nFeatures |= CPU_AVX2;
+    if (bOsAvx512 && (info[1] & (1 << 16)))
+        nFeatures |= CPU_AVX512F;
+    return nFeatures;
+#else
+    __builtin_cpu_init();
+    return (__builtin_cpu_supports("sse2") ? CPU_SSE2 : 0)
+        | (__builtin_cpu_supports("avx2") ? CPU_AVX2 : 0)
+        | (__builtin_cpu_supports("avx512f") ? CPU_AVX512F : 0);
+#endif
+}
+
+#endif
+
+struct TransformKernelInfo {
+    const char* sName;
+    TransformKernel kernel;
+    bool bSupported;
+};
+
+// Every kernel built in, fastest first
+inline const std::vector<TransformKernelInfo>& Transform_Kernels()
+{
+#ifdef OLC_TRANSFORM_X86
+    static const int nFeatures = Cpu_Features();
+    static const std::vector<TransformKernelInfo> vecKernels = {
+        { "avx512", Transform_AVX512, (nFeatures & CPU_AVX512F) != 0 },
+        { "avx2",   Transform_AVX2,   (nFeatures & CPU_AVX2) != 0 },
+        { "sse2",   Transform_SSE2,   (nFeatures & CPU_SSE2) != 0 },
+        { "scalar", Transform_Scalar, true },
+    };
+#else
+    static const std::vector<TransformKernelInfo> vecKernels = {
+        { "scalar", Transform_Scalar, true },
+    };
+#endif
+    return vecKernels;
+}
+
+// The kernel in use, the fastest supported one until Transform_SetKernel
+inline const TransformKernelInfo*& Transform_Current()
+{
+    static const TransformKernelInfo* pCurrent = [] {
+        for (auto& k : Transform_Kernels())
+            if (k.bSupported)
+                return &k;
+        return &Transform_Kernels().back();
+    }();
+    return pCurrent;
+}
+
+inline const char* Transform_KernelName()
+{
+    return Transform_Current()->sName;
+}
+
+// Force a kernel by name, e.g. to compare them. Fails if the CPU can't run it
+inline bool Transform_SetKernel(const char* sName)
+{
+    for (auto& k : Transform_Kernels()) {
+        if (strcmp(k.sName, sName) == 0 && k.bSupported) {
+            Transform_Current() = &k;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Transform vertices [nFirst, nLast) of in into the same places in out, which
+// must already be big enough. Separate ranges can run on separate threads
+inline void Transform_Range(const Mat4x4& m, const VertexStreams& in, VertexStreams& out, size_t nFirst, size_t nLast)
+{
+    Transform_Current()->kernel(m, in.x.data() + nFirst, in.y.data() + nFirst, in.z.data() + nFirst, in.w.data() + nFirst,
+        out.x.data() + nFirst, out.y.data() + nFirst, out.z.data() + nFirst, out.w.data() + nFirst, nLast - nFirst);
+}
+
+inline void Transform_Batch(const Mat4x4& m, const VertexStreams& in, VertexStreams& out)
+{
+    out.resize(in.size());
+    Transform_Range(m, in, out, 0, in.size());
+}
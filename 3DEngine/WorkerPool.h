@@ -0,0 +1,135 @@
+#pragma once
+
+// A fixed set of worker threads for splitting up a frame's work
+//
+// ParallelFor hands out job indices one at a time from a shared counter to the
+// workers and to the calling thread, and returns when every job has finished.
+// Jobs are small and numerous (a screen tile, a chunk of triangles), so uneven
+// ones balance themselves out. With one thread it just runs the jobs in order
+// on the caller, no workers are started at all. The job is handed to the
+// workers by pointer along with a plain function to call it through, so
+// unlike wrapping it in a std::function that never allocates.
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkerPool {
+public:
+    // nThreads counts the calling thread, 0 means one per hardware thread
+    WorkerPool(int nThreads = 0) {
+        if (nThreads <= 0)
+            nThreads = (int)std::thread::hardware_concurrency();
+        nThreadCount = nThreads > 0 ? nThreads : 1;
+
+        for (int i = 1; i < nThreadCount; i++)
+            vecWorkers.emplace_back(&WorkerPool::WorkerThread, this, i);
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mux);
+            bQuit = true;
+        }
+        cvWork.notify_all();
+        for (auto& t : vecWorkers)
+            t.join();
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    int ThreadCount() const { return nThreadCount; }
+
+    // Run job(i, nThread) for every i in [0, nJobs). nThread is in
+    // [0, ThreadCount()) and is 0 on the calling thread, so it can index
+    // per-thread scratch space. Not reentrant
+    template <typename JOB>
+    void ParallelFor(int nJobs, const JOB& job) {
+        if (nJobs <= 0)
+            return;
+        if (vecWorkers.empty() || nJobs == 1) {
+            for (int i = 0; i < nJobs; i++)
+                job(i, 0);
+            return;
+        }
+
+        Run(nJobs, &job, [](const void* p, int i, int nThread) { (*static_cast<const JOB*>(p))(i, nThread); });
+    }
+
+private:
+    typedef void (*JobCall)(const void* pJob, int i, int nThread);
+
+    void Run(int nJobs, const void* job, JobCall call) {
+        {
+            std::lock_guard<std::mutex> lock(mux);
+            pJob = job;
+            pCall = call;
+            nJobCount = nJobs;
+            nNextJob.store(0, std::memory_order_relaxed);
+            nJobsLeft.store(nJobs, std::memory_order_relaxed);
+            nGeneration++;
+        }
+        cvWork.notify_all();
+
+        RunJobs(job, call, nJobs, 0);
+
+        std::unique_lock<std::mutex> lock(mux);
+        cvDone.wait(lock, [&] { return nJobsLeft.load(std::memory_order_acquire) == 0 && nBusy == 0; });
+        pJob = nullptr;
+    }
+
+    void RunJobs(const void* job, JobCall call, int nJobs, int nThread) {
+        int i;
+        while ((i = nNextJob.fetch_add(1, std::memory_order_relaxed)) < nJobs) {
+            call(job, i, nThread);
+            nJobsLeft.fetch_sub(1, std::memory_order_acq_rel);
+        }
+    }
+
+    void WorkerThread(int nThread) {
+        uint64_t nSeen = 0;
+        std::unique_lock<std::mutex> lock(mux);
+        while (true) {
+            cvWork.wait(lock, [&] { return bQuit || nGeneration != nSeen; });
+            if (bQuit)
+                return;
+            nSeen = nGeneration;
+
+            // Late wakers can find the batch already finished and the job
+            // gone, in which case there's nothing to do until the next one
+            if (pJob == nullptr)
+                continue;
+            const void* job = pJob;
+            JobCall call = pCall;
+            int nJobs = nJobCount;
+            nBusy++;
+            lock.unlock();
+
+            RunJobs(job, call, nJobs, nThread);
+
+            lock.lock();
+            if (--nBusy == 0)
+                cvDone.notify_one();
+        }
+    }
+
+    int nThreadCount = 1;
+    std::vector<std::thread> vecWorkers;
+
+    std::mutex mux;
+    std::condition_variable cvWork;
+    std::condition_variable cvDone;
+    bool bQuit = false;
+    uint64_t nGeneration = 0;
+    int nBusy = 0;
+
+    const void* pJob = nullptr;
+    JobCall pCall = nullptr;
+    int nJobCount = 0;
+    std::atomic<int> nNextJob{ 0 };
+    std::atomic<int> nJobsLeft{ 0 };
+};
@@ -121,6 +121,8 @@ http://www.twitch.tv/javidx9
 */
 
 #pragma once
+
+#ifdef _WIN32
 #pragma comment(lib, "winmm.lib")
 
 #ifndef UNICODE
@@ -128,15 +130,69 @@ http://www.twitch.tv/javidx9
 Character Set -> Use Unicode. Thanks! - Javidx9
 #endif
 
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
 #include <windows.h>
+#endif
 
 #include <iostream>
+#include <algorithm>
 #include <chrono>
 #include <vector>
 #include <list>
+#include <string>
 #include <thread>
 #include <atomic>
+#include <mutex>
 #include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <cstdint>
+#include <cwchar>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OLC_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+#include <csignal>
+#include <cerrno>
+
+// There is no Win32 console here, so the engine runs on a VT terminal (see
+// ConstructTerminal) or headless (see ConstructHeadless). These stand-ins give
+// the frame buffer, sprite and input code the same types and layout they have
+// on Windows.
+typedef struct _COORD { short X; short Y; } COORD;
+typedef struct _SMALL_RECT { short Left; short Top; short Right; short Bottom; } SMALL_RECT;
+typedef struct _CHAR_INFO
+{
+	union { unsigned short UnicodeChar; char AsciiChar; } Char;
+	unsigned short Attributes;
+} CHAR_INFO;
+
+enum VIRTUAL_KEY
+{
+	VK_BACK = 0x08, VK_TAB = 0x09, VK_RETURN = 0x0D, VK_SHIFT = 0x10,
+	VK_CONTROL = 0x11, VK_ESCAPE = 0x1B, VK_SPACE = 0x20,
+	VK_LEFT = 0x25, VK_UP = 0x26, VK_RIGHT = 0x27, VK_DOWN = 0x28,
+};
+
+inline int _wfopen_s(FILE **f, const wchar_t *sFile, const wchar_t *sMode)
+{
+	std::string file(sFile, sFile + wcslen(sFile));
+	std::string mode(sMode, sMode + wcslen(sMode));
+	*f = fopen(file.c_str(), mode.c_str());
+	return *f == nullptr;
+}
+#endif
 
 enum COLOUR
 {
@@ -254,6 +310,10 @@ public:
 			return m_Colours[y * nWidth + x];
 	}
 
+	// Row y's nWidth glyphs and colours, unchecked, for copying whole rows
+	const short *GlyphRow(int y) const { return m_Glyphs + y * nWidth; }
+	const short *ColourRow(int y) const { return m_Colours + y * nWidth; }
+
 	short SampleGlyph(float x, float y)
 	{
 		int sx = (int)(x * (float)nWidth);
@@ -324,8 +384,10 @@ public:
 		m_nScreenWidth = 80;
 		m_nScreenHeight = 30;
 
+#ifdef _WIN32
 		m_hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
 		m_hConsoleIn = GetStdHandle(STD_INPUT_HANDLE);
+#endif
 
 		std::memset(m_keyNewState, 0, 256 * sizeof(short));
 		std::memset(m_keyOldState, 0, 256 * sizeof(short));
@@ -343,6 +405,12 @@ public:
 		m_bEnableSound = true;
 	}
 
+#ifndef _WIN32
+	int ConstructConsole(int /*width*/, int /*height*/, int /*fontw*/, int /*fonth*/)
+	{
+		return Error(L"No console on this platform, use ConstructTerminal() to draw in the terminal or ConstructHeadless() for benchmarks");
+	}
+#else
 	int ConstructConsole(int width, int height, int fontw, int fonth)
 	{
 		if (m_hConsole == INVALID_HANDLE_VALUE)
@@ -419,13 +487,114 @@ public:
 		if (!SetConsoleMode(m_hConsoleIn, ENABLE_EXTENDED_FLAGS | ENABLE_WINDOW_INPUT | ENABLE_MOUSE_INPUT))
 			return Error(L"SetConsoleMode");
 
-		// Allocate memory for screen buffer
-		m_bufScreen = new CHAR_INFO[m_nScreenWidth*m_nScreenHeight];
-		memset(m_bufScreen, 0, sizeof(CHAR_INFO) * m_nScreenWidth * m_nScreenHeight);
+		// Allocate memory for screen buffers
+		CreateScreenBuffers();
 
 		SetConsoleCtrlHandler((PHANDLER_ROUTINE)CloseHandler, TRUE);
 		return 1;
 	}
+#endif
+
+	// Create an off-screen frame buffer with no OS console behind it. Frames are
+	// drawn into m_bufScreen exactly as normal but never presented, and input is
+	// never polled, so OnUserUpdate() can be run and timed on machines without a
+	// console. If nFrames > 0 the engine stops after that many frames, otherwise
+	// it runs until OnUserUpdate() returns false
+	int ConstructHeadless(int width, int height, int nFrames = 0)
+	{
+		m_nScreenWidth = width;
+		m_nScreenHeight = height;
+		m_nFrameLimit = nFrames;
+		m_bHeadless = true;
+
+		CreateScreenBuffers();
+		return 1;
+	}
+
+	// Draw on a VT terminal instead of the Win32 console, e.g. on Linux or over
+	// SSH. Each frame goes to stdout as one write() of escape sequences, and keys
+	// are read from stdin. A width or height of 0 fills the terminal
+	int ConstructTerminal(int width = 0, int height = 0)
+	{
+#ifdef _WIN32
+		return Error(L"No VT terminal on this platform, use ConstructConsole()");
+#else
+		struct winsize ws;
+		bool bSized = ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0 && ws.ws_row > 0;
+		if (width <= 0 || height <= 0)
+		{
+			if (!bSized)
+				return Error(L"Terminal size unknown, give a width and height");
+			width = ws.ws_col;
+			height = ws.ws_row;
+		}
+		else if (bSized && (width > ws.ws_col || height > ws.ws_row))
+			return Error(L"Screen Width / Height Too Big For Terminal");
+
+		m_nScreenWidth = width;
+		m_nScreenHeight = height;
+		m_bTerminal = true;
+
+		// Keys arrive as they're typed, without echo, and reads never wait.
+		// Ctrl+C still interrupts, but ends the game cleanly
+		if (isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &m_termiosOriginal) == 0)
+		{
+			struct termios raw = m_termiosOriginal;
+			raw.c_lflag &= ~(ICANON | ECHO);
+			raw.c_cc[VMIN] = 0;
+			raw.c_cc[VTIME] = 0;
+			tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+			m_bTermiosSaved = true;
+		}
+		signal(SIGINT, TerminalInterrupt);
+		signal(SIGTERM, TerminalInterrupt);
+
+		// Alternate screen, cursor hidden, and no wrapping at the right edge so
+		// the bottom right cell can be drawn without scrolling
+		static const char sSetup[] = "\x1b[?1049h\x1b[?25l\x1b[?7l\x1b[0m\x1b[2J";
+		int nWrites = 0;
+		TerminalWrite(sSetup, sizeof(sSetup) - 1, nWrites);
+		m_bTerminalSetUp = true;
+
+		CreateScreenBuffers();
+		return 1;
+#endif
+	}
+
+	// How finished frames reach the console. PRESENT_SYNC presents each one on
+	// the game thread before the next is started. The other two hand it to a
+	// present thread and draw the next one meanwhile, in one of three screen
+	// buffers: PRESENT_LATEST never waits, and if the console falls behind
+	// only the newest finished frame is shown and the ones before it dropped,
+	// while PRESENT_FIFO shows every frame in order and makes the game wait
+	// when all three buffers are full. Consoles and terminals default to
+	// PRESENT_LATEST, headless engines to PRESENT_SYNC. Set it before Start()
+	enum PRESENT_MODE
+	{
+		PRESENT_SYNC,
+		PRESENT_LATEST,
+		PRESENT_FIFO,
+	};
+
+	void SetPresentMode(PRESENT_MODE mode)
+	{
+		m_nPresentMode = mode;
+	}
+
+	// Present frames as the VT escape stream the terminal would be sent.
+	// ConstructTerminal() turns this on; a headless engine can turn it on to
+	// measure the stream, which is then built but never written
+	void SetTerminalOutput(bool bTerminal)
+	{
+		m_bTerminal = bTerminal;
+	}
+
+	// Use the VT repeat sequence (ESC [ n b) for runs of identical cells. Most
+	// terminals know it, but not all, so it's off unless asked for
+	void SetTerminalRepeat(bool bRepeat)
+	{
+		m_bTerminalRepeat = bRepeat;
+	}
 
 	virtual void Draw(int x, int y, short c = 0x2588, short col = 0x000F)
 	{
@@ -436,34 +605,84 @@ public:
 		}
 	}
 
+	// The span primitives below write whole runs of a row straight into the
+	// screen buffer, clipped once per call rather than once per cell. Fill,
+	// the strings, FillCircle and the sprites are built on them, so like the
+	// triangle fills they don't go through an overridden Draw()
+
+	// Set every cell of the screen, as one run of SIMD stores
+	void Clear(short c = 0x2588, short col = 0x000F)
+	{
+		FillCells(m_bufScreen, m_nScreenWidth * m_nScreenHeight, MakeCell(c, col));
+	}
+
+	// Set the n cells of row y from x on
+	void FillRun(int x, int y, int n, short c = 0x2588, short col = 0x000F)
+	{
+		if (y < 0 || y >= m_nScreenHeight)
+			return;
+		if (x < 0) { n += x; x = 0; }
+		if (n > m_nScreenWidth - x) n = m_nScreenWidth - x;
+		if (n > 0)
+			FillCells(m_bufScreen + y * m_nScreenWidth + x, n, MakeCell(c, col));
+	}
+
+	// Copy n cells into row y from x on: glyph i is pGlyphs[i], its colour
+	// pColours[i], or col for all of them when pColours is null. With bAlpha
+	// spaces are skipped, leaving what was beneath
+	template <typename T>
+	void BlitRow(int x, int y, const T *pGlyphs, const short *pColours, int n, short col = 0x000F, bool bAlpha = false)
+	{
+		if (y < 0 || y >= m_nScreenHeight)
+			return;
+		if (x < 0)
+		{
+			pGlyphs -= x;
+			if (pColours) pColours -= x;
+			n += x;
+			x = 0;
+		}
+		if (n > m_nScreenWidth - x) n = m_nScreenWidth - x;
+		if (n > 0)
+			CopyCells(m_bufScreen + y * m_nScreenWidth + x, pGlyphs, pColours, n, col, bAlpha);
+	}
+
 	void Fill(int x1, int y1, int x2, int y2, short c = 0x2588, short col = 0x000F)
 	{
 		Clip(x1, y1);
 		Clip(x2, y2);
-		for (int x = x1; x < x2; x++)
+		if (x1 >= x2 || y1 >= y2)
+			return;
+
+		// Rows the full width of the screen follow each other in the buffer
+		CHAR_INFO cell = MakeCell(c, col);
+		if (x2 - x1 == m_nScreenWidth)
+			FillCells(m_bufScreen + y1 * m_nScreenWidth, (y2 - y1) * m_nScreenWidth, cell);
+		else
 			for (int y = y1; y < y2; y++)
-				Draw(x, y, c, col);
+				FillCells(m_bufScreen + y * m_nScreenWidth + x1, x2 - x1, cell);
 	}
 
-	void DrawString(int x, int y, std::wstring c, short col = 0x000F)
+	// The const wchar_t* overloads draw a literal without building a
+	// std::wstring for it first, which would allocate on every call
+	void DrawString(int x, int y, const std::wstring &c, short col = 0x000F)
 	{
-		for (size_t i = 0; i < c.size(); i++)
-		{
-			m_bufScreen[y * m_nScreenWidth + x + i].Char.UnicodeChar = c[i];
-			m_bufScreen[y * m_nScreenWidth + x + i].Attributes = col;
-		}
+		BlitRow(x, y, c.c_str(), nullptr, (int)c.size(), col);
 	}
 
-	void DrawStringAlpha(int x, int y, std::wstring c, short col = 0x000F)
+	void DrawString(int x, int y, const wchar_t *c, short col = 0x000F)
 	{
-		for (size_t i = 0; i < c.size(); i++)
-		{
-			if (c[i] != L' ')
-			{
-				m_bufScreen[y * m_nScreenWidth + x + i].Char.UnicodeChar = c[i];
-				m_bufScreen[y * m_nScreenWidth + x + i].Attributes = col;
-			}
-		}
+		BlitRow(x, y, c, nullptr, (int)wcslen(c), col);
+	}
+
+	void DrawStringAlpha(int x, int y, const std::wstring &c, short col = 0x000F)
+	{
+		BlitRow(x, y, c.c_str(), nullptr, (int)c.size(), col, true);
+	}
+
+	void DrawStringAlpha(int x, int y, const wchar_t *c, short col = 0x000F)
+	{
+		BlitRow(x, y, c, nullptr, (int)wcslen(c), col, true);
 	}
 
 	void Clip(int &x, int &y)
@@ -533,11 +752,468 @@ public:
 		DrawLine(x3, y3, x1, y1, c, col);
 	}
 
-	// https://www.avrfreaks.net/sites/default/files/triangles.c
+	// Reset every cell of the depth buffer to "nothing drawn here yet", creating
+	// the buffer the first time. Must be called before FillTriangleDepth()
+	void ClearDepth()
+	{
+		if (m_bufDepth == nullptr)
+			m_bufDepth = new float[m_nScreenWidth*m_nScreenHeight];
+		std::fill(m_bufDepth, m_bufDepth + m_nScreenWidth * m_nScreenHeight, std::numeric_limits<float>::max());
+	}
+
+	// Fill a triangle, but only the cells where it is nearer (smaller z) than
+	// whatever is already there, updating the depth buffer as it goes. z is
+	// interpolated linearly across the screen, so it should be post-projection
+	// depth. Cells are covered when their centre is inside the triangle, with
+	// a top-left rule on the edges, in 1/16th cell fixed point so that
+	// triangles sharing an edge neither overlap nor leave gaps. Writes straight
+	// into the screen buffer rather than through Draw()
+	void FillTriangleDepth(float x1, float y1, float z1, float x2, float y2, float z2, float x3, float y3, float z3, short c = 0x2588, short col = 0x000F)
+	{
+		FillTriangleDepth(x1, y1, z1, x2, y2, z2, x3, y3, z3, c, col, 0, 0, m_nScreenWidth, m_nScreenHeight);
+	}
+
+	// The same, drawing only inside the clip rectangle [clipx1, clipx2) x
+	// [clipy1, clipy2), which must lie on the screen. With a pPattern the
+	// cells come from it rather than c and col, as for FillTriangleClipped
+	void FillTriangleDepth(float x1, float y1, float z1, float x2, float y2, float z2, float x3, float y3, float z3, short c, short col,
+		int clipx1, int clipy1, int clipx2, int clipy2, const CHAR_INFO *pPattern = nullptr)
+	{
+		const int SUB = 16;
+		int64_t X1 = (int64_t)lroundf(x1 * SUB), Y1 = (int64_t)lroundf(y1 * SUB);
+		int64_t X2 = (int64_t)lroundf(x2 * SUB), Y2 = (int64_t)lroundf(y2 * SUB);
+		int64_t X3 = (int64_t)lroundf(x3 * SUB), Y3 = (int64_t)lroundf(y3 * SUB);
+
+		// Make the winding clockwise on screen, so inside is where all three
+		// edge functions are positive
+		int64_t nArea = (X2 - X1) * (Y3 - Y1) - (Y2 - Y1) * (X3 - X1);
+		if (nArea == 0)
+			return;
+		if (nArea < 0)
+		{
+			std::swap(X2, X3); std::swap(Y2, Y3); std::swap(z2, z3);
+			nArea = -nArea;
+		}
+
+		int minx = std::max(clipx1, (int)(std::min({ X1, X2, X3 }) / SUB));
+		int maxx = std::min(clipx2 - 1, (int)(std::max({ X1, X2, X3 }) / SUB));
+		int miny = std::max(clipy1, (int)(std::min({ Y1, Y2, Y3 }) / SUB));
+		int maxy = std::min(clipy2 - 1, (int)(std::max({ Y1, Y2, Y3 }) / SUB));
+		if (minx > maxx || miny > maxy)
+			return;
+
+		// Edge function of a->b at the centre of cell (minx, miny), how much it
+		// changes per cell across and down, and the top-left bias: cells exactly
+		// on an edge belong to the triangle only for top and left edges
+		struct Edge { int64_t e, dx, dy; };
+		int64_t PX = (int64_t)minx * SUB + SUB / 2, PY = (int64_t)miny * SUB + SUB / 2;
+		auto edge = [&](int64_t Xa, int64_t Ya, int64_t Xb, int64_t Yb)
+		{
+			bool bTopLeft = (Yb - Ya) < 0 || ((Yb - Ya) == 0 && (Xb - Xa) > 0);
+			return Edge{ (Xb - Xa) * (PY - Ya) - (Yb - Ya) * (PX - Xa) - (bTopLeft ? 0 : 1), -(Yb - Ya) * SUB, (Xb - Xa) * SUB };
+		};
+		Edge e23 = edge(X2, Y2, X3, Y3), e31 = edge(X3, Y3, X1, Y1), e12 = edge(X1, Y1, X2, Y2);
+
+		// Depth is a plane over the screen, weighted by the edge functions. It's
+		// evaluated from cell (0, 0) rather than stepped from the corner of the
+		// clip rectangle, so every cell gets the same z whatever the clipping
+		float fInvArea = 1.0f / (float)nArea;
+		auto plane = [&](int64_t w1, int64_t w2, int64_t w3) { return ((float)w1 * z1 + (float)w2 * z2 + (float)w3 * z3) * fInvArea; };
+		float dzdx = plane(e23.dx, e31.dx, e12.dx);
+		float dzdy = plane(e23.dy, e31.dy, e12.dy);
+		float z0 = plane(e23.e - e23.dx * minx - e23.dy * miny, e31.e - e31.dx * minx - e31.dy * miny, e12.e - e12.dx * minx - e12.dy * miny);
+
+		CHAR_INFO cell = MakeCell(c, col);
+		const CHAR_INFO solid[4] = { cell, cell, cell, cell };
+		int64_t nFilled = 0;
+		for (int y = miny; y <= maxy; y++)
+		{
+			int64_t w1 = e23.e, w2 = e31.e, w3 = e12.e;
+			float zRow = z0 + dzdy * (float)y;
+			const CHAR_INFO *pRow = pPattern ? pPattern + (y & 3) * 4 : solid;
+			CHAR_INFO *pCell = m_bufScreen + y * m_nScreenWidth + minx;
+			float *pDepth = m_bufDepth + y * m_nScreenWidth + minx;
+			for (int x = minx; x <= maxx; x++, pCell++, pDepth++)
+			{
+				float z = zRow + dzdx * (float)x;
+				if ((w1 | w2 | w3) >= 0 && z < *pDepth)
+				{
+					*pDepth = z;
+					*pCell = pRow[x & 3];
+					nFilled++;
+				}
+				w1 += e23.dx; w2 += e31.dx; w3 += e12.dx;
+			}
+			e23.e += e23.dy; e31.e += e31.dy; e12.e += e12.dy;
+		}
+		AddCellsFilled(nFilled);
+	}
+
+	// Fill triangles with FillTriangleHalfSpace() rather than by walking their
+	// edges. The cells covered differ slightly, so switching changes frames
+	void SetHalfSpaceRaster(bool bHalfSpace)
+	{
+		m_bHalfSpaceRaster = bHalfSpace;
+	}
+
+	bool HalfSpaceRaster()
+	{
+		return m_bHalfSpaceRaster;
+	}
+
+	// Count the cells the triangle fills write, for measuring fill rate. Off
+	// by default, as every fill then adds to one counter shared by all the
+	// threads drawing
+	void SetCountCellsFilled(bool bCount)
+	{
+		m_bCountCellsFilled = bCount;
+	}
+
+	// Cells the triangle fills have written while counting was on. Safe to
+	// read while triangles are being drawn on several threads
+	uint64_t CellsFilled()
+	{
+		return (uint64_t)m_nCellsFilled.load(std::memory_order_relaxed);
+	}
+
 	void FillTriangle(int x1, int y1, int x2, int y2, int x3, int y3, short c = 0x2588, short col = 0x000F)
+	{
+		if (m_bHalfSpaceRaster)
+		{
+			FillTriangleHalfSpace(x1, y1, x2, y2, x3, y3, c, col, 0, 0, m_nScreenWidth, m_nScreenHeight);
+			return;
+		}
+
+		int64_t nFilled = 0;
+		FillTriangleSpans(x1, y1, x2, y2, x3, y3, [&](int sx, int ex, int ny)
+		{
+			for (int i = sx; i <= ex; i++)
+				Draw(i, ny, c, col);
+			if (ny >= 0 && ny < m_nScreenHeight)
+				nFilled += std::max(0, std::min(ex, m_nScreenWidth - 1) - std::max(sx, 0) + 1);
+		});
+		AddCellsFilled(nFilled);
+	}
+
+	// As FillTriangle, but only the cells inside the clip rectangle [clipx1,
+	// clipx2) x [clipy1, clipy2) are drawn, straight into the screen buffer.
+	// The rectangle must lie on the screen. Drawing a triangle once per tile of
+	// the screen like this gives exactly the cells FillTriangle would.
+	// pPattern, if given, is a 4x4 tile of cells repeated across the screen
+	// from (0, 0) that the cells are taken from instead of c and col, cell
+	// (x, y) getting pPattern[(y & 3) * 4 + (x & 3)] - an ordered dither
+	void FillTriangleClipped(int x1, int y1, int x2, int y2, int x3, int y3, short c, short col, int clipx1, int clipy1, int clipx2, int clipy2,
+		const CHAR_INFO *pPattern = nullptr)
+	{
+		if (m_bHalfSpaceRaster)
+		{
+			FillTriangleHalfSpace(x1, y1, x2, y2, x3, y3, c, col, clipx1, clipy1, clipx2, clipy2, pPattern);
+			return;
+		}
+		FillTriangleSpansClipped(x1, y1, x2, y2, x3, y3, c, col, clipx1, clipy1, clipx2, clipy2, pPattern);
+	}
+
+	// Index of the lowest and highest set bit of n, which mustn't be 0
+	static int LowestBit(unsigned n)
+	{
+#ifdef _MSC_VER
+		unsigned long i;
+		_BitScanForward(&i, n);
+		return (int)i;
+#else
+		return __builtin_ctz(n);
+#endif
+	}
+
+	static int HighestBit(unsigned n)
+	{
+#ifdef _MSC_VER
+		unsigned long i;
+		_BitScanReverse(&i, n);
+		return (int)i;
+#else
+		return 31 - __builtin_clz(n);
+#endif
+	}
+
+	static CHAR_INFO MakeCell(short c, short col)
+	{
+		CHAR_INFO cell;
+		cell.Char.UnicodeChar = c;
+		cell.Attributes = col;
+		return cell;
+	}
+
+	// Copy n glyphs and their colours (or col for all) into the cells from p,
+	// skipping spaces with bAlpha; the test is hoisted out of the loop
+	template <typename T>
+	static void CopyCells(CHAR_INFO *p, const T *pGlyphs, const short *pColours, int n, short col, bool bAlpha)
+	{
+		if (bAlpha)
+		{
+			for (int i = 0; i < n; i++)
+				if (pGlyphs[i] != L' ')
+					p[i] = MakeCell((short)pGlyphs[i], pColours ? pColours[i] : col);
+		}
+		else if (pColours)
+		{
+			for (int i = 0; i < n; i++)
+				p[i] = MakeCell((short)pGlyphs[i], pColours[i]);
+		}
+		else
+		{
+			for (int i = 0; i < n; i++)
+				p[i] = MakeCell((short)pGlyphs[i], col);
+		}
+	}
+
+	// Fill n cells from p with the same glyph and colour, four at a time
+	static void FillCells(CHAR_INFO *p, int n, CHAR_INFO cell)
+	{
+#ifdef OLC_SSE2
+		static_assert(sizeof(CHAR_INFO) == 4, "a CHAR_INFO is stored as one 32-bit lane");
+		uint32_t nCell;
+		memcpy(&nCell, &cell, sizeof(nCell));
+		__m128i q = _mm_set1_epi32((int)nCell);
+		for (; n >= 4; n -= 4, p += 4)
+			_mm_storeu_si128((__m128i *)p, q);
+#endif
+		for (; n > 0; n--)
+			*p++ = cell;
+	}
+
+	// Fill n cells from p, the first of them in column x, with a row of a 4x4
+	// pattern repeated across the screen, so that column x gets pRow[x & 3]
+	static void FillCellsPattern(CHAR_INFO *p, int x, int n, const CHAR_INFO *pRow)
+	{
+		const CHAR_INFO q[4] = { pRow[x & 3], pRow[(x + 1) & 3], pRow[(x + 2) & 3], pRow[(x + 3) & 3] };
+#ifdef OLC_SSE2
+		__m128i v = _mm_loadu_si128((const __m128i *)q);
+		for (; n >= 4; n -= 4, p += 4)
+			_mm_storeu_si128((__m128i *)p, v);
+#endif
+		for (int i = 0; i < n; i++)
+			p[i] = q[i & 3];
+	}
+
+	// Fill a triangle by testing cells against its three edge functions rather
+	// than walking its edges. The vertices are whole cells, so the edge
+	// functions are exact integers, fixed point with the cell as the unit. A
+	// cell is inside when its centre is; centres exactly on an edge go to the
+	// triangle only for top and left edges, so triangles sharing an edge
+	// neither overlap nor leave gaps. Cells are taken in 8x8 blocks: a block
+	// wholly outside an edge is skipped, one wholly inside all three is filled
+	// row by row, and only blocks an edge crosses test their cells, a row of 8
+	// at a time. What each row of a row of blocks covers is gathered into one
+	// run and filled in one go. Draws only [clipx1, clipx2) x [clipy1, clipy2),
+	// which must lie on the screen, straight into the screen buffer, from
+	// pPattern if given as for FillTriangleClipped
+	void FillTriangleHalfSpace(int x1, int y1, int x2, int y2, int x3, int y3, short c, short col, int clipx1, int clipy1, int clipx2, int clipy2,
+		const CHAR_INFO *pPattern = nullptr)
+	{
+		int minx = std::max(clipx1, std::min({ x1, x2, x3 })), maxx = std::min(clipx2 - 1, std::max({ x1, x2, x3 }));
+		int miny = std::max(clipy1, std::min({ y1, y2, y3 })), maxy = std::min(clipy2 - 1, std::max({ y1, y2, y3 }));
+		if (minx > maxx || miny > maxy)
+			return;
+
+		// The edge functions are stepped in 32 bits, which holds them for
+		// triangles up to 16383 cells across. Anything bigger is walked instead
+		const int64_t MAX_EXTENT = 16383;
+		if ((int64_t)std::max({ x1, x2, x3 }) - std::min({ x1, x2, x3 }) > MAX_EXTENT ||
+			(int64_t)std::max({ y1, y2, y3 }) - std::min({ y1, y2, y3 }) > MAX_EXTENT)
+		{
+			FillTriangleSpansClipped(x1, y1, x2, y2, x3, y3, c, col, clipx1, clipy1, clipx2, clipy2, pPattern);
+			return;
+		}
+
+		// Make the winding clockwise on screen, so inside is where all three
+		// edge functions are positive
+		int64_t nArea = (int64_t)(x2 - x1) * (y3 - y1) - (int64_t)(y2 - y1) * (x3 - x1);
+		if (nArea == 0)
+			return;
+		if (nArea < 0)
+		{
+			std::swap(x2, x3);
+			std::swap(y2, y3);
+		}
+
+		// Edge function of a->b at cell (0, 0), less the top-left bias, how much
+		// it changes per cell across and down, and how much more it is at the
+		// cells of an 8x8 block where it's smallest and largest than at the
+		// block's top left cell
+		struct Edge { int64_t e; int dx, dy, nMin, nMax; };
+		auto edge = [](int xa, int ya, int xb, int yb)
+		{
+			bool bTopLeft = (yb - ya) < 0 || ((yb - ya) == 0 && (xb - xa) > 0);
+			int dx = -(yb - ya), dy = xb - xa;
+			return Edge{ (int64_t)(xb - xa) * -ya - (int64_t)(yb - ya) * -xa - (bTopLeft ? 0 : 1), dx, dy,
+				7 * (std::min(dx, 0) + std::min(dy, 0)), 7 * (std::max(dx, 0) + std::max(dy, 0)) };
+		};
+		const Edge edges[3] = { edge(x2, y2, x3, y3), edge(x3, y3, x1, y1), edge(x1, y1, x2, y2) };
+
+		CHAR_INFO cell;
+		cell.Char.UnicodeChar = c;
+		cell.Attributes = col;
+
+#ifdef OLC_SSE2
+		__m128i vStep[3], vStep4[3], vStepY[3];
+		for (int k = 0; k < 3; k++)
+		{
+			vStep[k] = _mm_setr_epi32(0, edges[k].dx, 2 * edges[k].dx, 3 * edges[k].dx);
+			vStep4[k] = _mm_set1_epi32(4 * edges[k].dx);
+			vStepY[k] = _mm_set1_epi32(edges[k].dy);
+		}
+#endif
+
+		int64_t nFilled = 0;
+		for (int by = miny & ~7; by <= maxy; by += 8)
+		{
+			int cy1 = std::max(by, miny), cy2 = std::min(by + 7, maxy);
+
+			// The run each row covers, [nRunFirst, nRunLast], empty until found
+			int nRunFirst[8], nRunLast[8];
+			for (int i = 0; i < 8; i++)
+			{
+				nRunFirst[i] = std::numeric_limits<int>::max();
+				nRunLast[i] = std::numeric_limits<int>::min();
+			}
+			auto cover = [&](int y, int x1, int x2)
+			{
+				nRunFirst[y - by] = std::min(nRunFirst[y - by], x1);
+				nRunLast[y - by] = std::max(nRunLast[y - by], x2);
+			};
+
+			// Blocks wholly inside all cover the same columns of every row
+			int nInsideFirst = std::numeric_limits<int>::max(), nInsideLast = std::numeric_limits<int>::min();
+
+			// Each edge at the top left cell of the block, stepped along the row
+			int wBlock[3];
+			for (int k = 0; k < 3; k++)
+				wBlock[k] = (int)(edges[k].e + (int64_t)edges[k].dx * (minx & ~7) + (int64_t)edges[k].dy * by);
+
+			bool bFound = false;
+			for (int bx = minx & ~7; bx <= maxx; bx += 8)
+			{
+				int w[3] = { wBlock[0], wBlock[1], wBlock[2] };
+				for (int k = 0; k < 3; k++)
+					wBlock[k] += 8 * edges[k].dx;
+
+				// Outside if any edge is negative even where it's largest. The
+				// blocks not outside are all in one stretch of the row, so the
+				// first outside after them ends it
+				if (w[0] + edges[0].nMax < 0 || w[1] + edges[1].nMax < 0 || w[2] + edges[2].nMax < 0)
+				{
+					if (bFound)
+						break;
+					continue;
+				}
+				bFound = true;
+
+				int cx1 = std::max(bx, minx), cx2 = std::min(bx + 7, maxx);
+				if (w[0] + edges[0].nMin >= 0 && w[1] + edges[1].nMin >= 0 && w[2] + edges[2].nMin >= 0)
+				{
+					nInsideFirst = std::min(nInsideFirst, cx1);
+					nInsideLast = std::max(nInsideLast, cx2);
+					continue;
+				}
+
+				// A set bit for each of the block's 8 columns that are drawn
+				unsigned nColumns = (0xFFu >> (7 - (cx2 - cx1))) << (cx1 - bx);
+				for (int k = 0; k < 3; k++)
+					w[k] += edges[k].dy * (cy1 - by);
+#ifdef OLC_SSE2
+				__m128i vLo[3], vHi[3];
+				for (int k = 0; k < 3; k++)
+				{
+					vLo[k] = _mm_add_epi32(_mm_set1_epi32(w[k]), vStep[k]);
+					vHi[k] = _mm_add_epi32(vLo[k], vStep4[k]);
+				}
+#endif
+				for (int y = cy1; y <= cy2; y++)
+				{
+#ifdef OLC_SSE2
+					// A sign bit set in any edge function means outside
+					__m128i vOutLo = _mm_or_si128(_mm_or_si128(vLo[0], vLo[1]), vLo[2]);
+					__m128i vOutHi = _mm_or_si128(_mm_or_si128(vHi[0], vHi[1]), vHi[2]);
+					unsigned nOutside = (unsigned)_mm_movemask_ps(_mm_castsi128_ps(vOutLo)) | ((unsigned)_mm_movemask_ps(_mm_castsi128_ps(vOutHi)) << 4);
+					unsigned nInside = ~nOutside & nColumns;
+					for (int k = 0; k < 3; k++)
+					{
+						vLo[k] = _mm_add_epi32(vLo[k], vStepY[k]);
+						vHi[k] = _mm_add_epi32(vHi[k], vStepY[k]);
+					}
+#else
+					unsigned nInside = 0;
+					for (int i = 0; i < 8; i++)
+						if (((w[0] + edges[0].dx * i) | (w[1] + edges[1].dx * i) | (w[2] + edges[2].dx * i)) >= 0)
+							nInside |= 1u << i;
+					nInside &= nColumns;
+					for (int k = 0; k < 3; k++)
+						w[k] += edges[k].dy;
+#endif
+					if (nInside == 0)
+						continue;
+
+					cover(y, bx + LowestBit(nInside), bx + HighestBit(nInside));
+				}
+			}
+
+			// A row of a triangle is all one run, so the pieces of it each
+			// block found join up
+			for (int y = cy1; y <= cy2; y++)
+			{
+				if (nInsideFirst <= nInsideLast)
+					cover(y, nInsideFirst, nInsideLast);
+				if (nRunFirst[y - by] > nRunLast[y - by])
+					continue;
+				CHAR_INFO *pRun = m_bufScreen + y * m_nScreenWidth + nRunFirst[y - by];
+				if (pPattern)
+					FillCellsPattern(pRun, nRunFirst[y - by], nRunLast[y - by] - nRunFirst[y - by] + 1, pPattern + (y & 3) * 4);
+				else
+					FillCells(pRun, nRunLast[y - by] - nRunFirst[y - by] + 1, cell);
+				nFilled += nRunLast[y - by] - nRunFirst[y - by] + 1;
+			}
+		}
+		AddCellsFilled(nFilled);
+	}
+
+	// FillTriangleClipped() by walking the edges
+	void FillTriangleSpansClipped(int x1, int y1, int x2, int y2, int x3, int y3, short c, short col, int clipx1, int clipy1, int clipx2, int clipy2,
+		const CHAR_INFO *pPattern = nullptr)
+	{
+		CHAR_INFO cell = MakeCell(c, col);
+		int64_t nFilled = 0;
+		FillTriangleSpans(x1, y1, x2, y2, x3, y3, [&](int sx, int ex, int ny)
+		{
+			if (ny < clipy1 || ny >= clipy2)
+				return;
+			sx = std::max(sx, clipx1);
+			ex = std::min(ex, clipx2 - 1);
+			if (sx > ex)
+				return;
+			CHAR_INFO *pCell = m_bufScreen + ny * m_nScreenWidth + sx;
+			if (pPattern)
+				FillCellsPattern(pCell, sx, ex - sx + 1, pPattern + (ny & 3) * 4);
+			else
+				FillCells(pCell, ex - sx + 1, cell);
+			nFilled += ex - sx + 1;
+		});
+		AddCellsFilled(nFilled);
+	}
+
+	void AddCellsFilled(int64_t nFilled)
+	{
+		if (m_bCountCellsFilled)
+			m_nCellsFilled.fetch_add(nFilled, std::memory_order_relaxed);
+	}
+
+	// https://www.avrfreaks.net/sites/default/files/triangles.c
+	// Walks the triangle's edges and calls drawline(sx, ex, y) for each row of
+	// it, with sx <= ex both inclusive
+	template <typename SPAN>
+	void FillTriangleSpans(int x1, int y1, int x2, int y2, int x3, int y3, SPAN drawline)
 	{
 		auto SWAP = [](int &x, int &y) { int t = x; x = y; y = t; };
-		auto drawline = [&](int sx, int ex, int ny) { for (int i = sx; i <= ex; i++) Draw(i, ny, c, col); };
 		
 		int t1x, t2x, y, minx, maxx, t1xp, t2xp;
 		bool changed1 = false;
@@ -703,8 +1379,7 @@ public:
 
 		auto drawline = [&](int sx, int ex, int ny)
 		{
-			for (int i = sx; i <= ex; i++)
-				Draw(i, ny, c, col);
+			FillRun(sx, ny, ex - sx + 1, c, col);
 		};
 
 		while (y >= x)
@@ -724,14 +1399,7 @@ public:
 		if (sprite == nullptr)
 			return;
 
-		for (int i = 0; i < sprite->nWidth; i++)
-		{
-			for (int j = 0; j < sprite->nHeight; j++)
-			{
-				if (sprite->GetGlyph(i, j) != L' ')
-					Draw(x + i, y + j, sprite->GetGlyph(i, j), sprite->GetColour(i, j));
-			}
-		}
+		DrawPartialSprite(x, y, sprite, 0, 0, sprite->nWidth, sprite->nHeight);
 	}
 
 	void DrawPartialSprite(int x, int y, olcSprite *sprite, int ox, int oy, int w, int h)
@@ -739,14 +1407,21 @@ public:
 		if (sprite == nullptr)
 			return;
 
-		for (int i = 0; i < w; i++)
+		// Cells outside the sprite read as spaces and so are never drawn: trim
+		// the source rectangle to the sprite, then the destination to the screen
+		auto trim = [](int &nDst, int &nSrc, int &nLen, int nSrcMax, int nDstMax)
 		{
-			for (int j = 0; j < h; j++)
-			{
-				if (sprite->GetGlyph(i+ox, j+oy) != L' ')
-					Draw(x + i, y + j, sprite->GetGlyph(i+ox, j+oy), sprite->GetColour(i+ox, j+oy));
-			}
-		}
+			if (nSrc < 0) { nDst -= nSrc; nLen += nSrc; nSrc = 0; }
+			if (nDst < 0) { nSrc -= nDst; nLen += nDst; nDst = 0; }
+			nLen = std::min(nLen, std::min(nSrcMax - nSrc, nDstMax - nDst));
+		};
+		trim(x, ox, w, sprite->nWidth, m_nScreenWidth);
+		trim(y, oy, h, sprite->nHeight, m_nScreenHeight);
+		if (w <= 0 || h <= 0)
+			return;
+
+		for (int j = 0; j < h; j++)
+			CopyCells(m_bufScreen + (y + j) * m_nScreenWidth + x, sprite->GlyphRow(oy + j) + ox, sprite->ColourRow(oy + j) + ox, w, 0, true);
 	}
 
 	void DrawWireFrameModel(const std::vector<std::pair<float, float>> &vecModelCoordinates, float x, float y, float r = 0.0f, float s = 1.0f, short col = FG_WHITE, short c = PIXEL_SOLID)
@@ -791,8 +1466,16 @@ public:
 
 	~olcConsoleGameEngine()
 	{
-		SetConsoleActiveScreenBuffer(m_hOriginalConsole);
-		delete[] m_bufScreen;
+#ifdef _WIN32
+		if (!m_bHeadless)
+			SetConsoleActiveScreenBuffer(m_hOriginalConsole);
+#else
+		RestoreTerminal();
+#endif
+		for (CHAR_INFO *buf : m_bufScreens)
+			delete[] buf;
+		delete[] m_bufPresented;
+		delete[] m_bufDepth;
 	}
 
 public:
@@ -816,6 +1499,46 @@ public:
 		return m_nScreenHeight;
 	}
 
+	// Frames completed since Start(), and the frame buffer they are drawn into.
+	// Mostly useful for headless runs that want to check or hash the output.
+	// With a present thread the buffer changes from frame to frame, but it
+	// always starts out holding the frame before
+	int FrameCount()
+	{
+		return m_nFrameCount;
+	}
+
+	const CHAR_INFO *ScreenBuffer()
+	{
+		return m_bufScreen;
+	}
+
+	// What the last Present() sent to the console. Only cells that changed
+	// since the frame before are sent, in runs along rows. The Win32 console
+	// is written a rectangle at a time, a terminal gets an escape stream in
+	// one write(). Headless engines work all this out too, they just don't
+	// write anything
+	struct sPresentStats
+	{
+		int nRuns = 0;		// runs of changed cells
+		int nCells = 0;		// cells in them
+		int nWrites = 0;	// rectangles written, or write() calls made
+		size_t nBytes = 0;	// bytes in the rectangles, or in the stream
+	};
+
+	sPresentStats PresentStats()
+	{
+		std::lock_guard<std::mutex> lock(m_muxPresent);
+		return m_presentStats;
+	}
+
+	// Finished frames PRESENT_LATEST replaced with newer ones before they
+	// could be shown
+	int FramesDropped()
+	{
+		return m_nFramesDropped;
+	}
+
 private:
 	void GameThread()
 	{
@@ -833,11 +1556,21 @@ private:
 			}
 		}
 
+		if (m_nPresentMode < 0)
+			m_nPresentMode = m_bHeadless ? PRESENT_SYNC : PRESENT_LATEST;
+		CreatePresentBuffers();
+
 		auto tp1 = std::chrono::system_clock::now();
 		auto tp2 = std::chrono::system_clock::now();
 
 		while (m_bAtomActive)
 		{
+			if (m_nPresentMode != PRESENT_SYNC)
+			{
+				m_bPresentQuit = false;
+				m_thPresent = std::thread(&olcConsoleGameEngine::PresentThread, this);
+			}
+
 			// Run as fast as possible
 			while (m_bAtomActive)
 			{
@@ -847,132 +1580,674 @@ private:
 				tp1 = tp2;
 				float fElapsedTime = elapsedTime.count();
 
-				// Handle Keyboard Input
-				for (int i = 0; i < 256; i++)
+				// Handle Input - a headless engine has no console to read, so
+				// whatever the application put in m_keys[] is left alone
+				if (!m_bHeadless)
+					HandleInput(fElapsedTime);
+
+				// Handle Frame Update
+				if (!OnUserUpdate(fElapsedTime))
+					m_bAtomActive = false;
+
+				m_nFrameCount++;
+				if (m_nFrameLimit > 0 && m_nFrameCount >= m_nFrameLimit)
+					m_bAtomActive = false;
+
+				// Update Title & Present Screen Buffer
+				if (m_nPresentMode == PRESENT_SYNC)
+					Present(m_bufScreen, fElapsedTime);
+				else
+					SubmitFrame(fElapsedTime);
+			}
+
+			// Let the present thread show what it's been given, then stop it
+			if (m_thPresent.joinable())
+			{
 				{
-					m_keyNewState[i] = GetAsyncKeyState(i);
+					std::lock_guard<std::mutex> lock(m_muxPresent);
+					m_bPresentQuit = true;
+				}
+				m_cvPresent.notify_all();
+				m_thPresent.join();
+			}
 
-					m_keys[i].bPressed = false;
-					m_keys[i].bReleased = false;
+			if (m_bEnableSound)
+			{
+				// Close and Clean up audio system
+			}
 
-					if (m_keyNewState[i] != m_keyOldState[i])
-					{
-						if (m_keyNewState[i] & 0x8000)
-						{
-							m_keys[i].bPressed = !m_keys[i].bHeld;
-							m_keys[i].bHeld = true;
-						}
-						else
-						{
-							m_keys[i].bReleased = true;
-							m_keys[i].bHeld = false;
-						}
-					}
+			// Allow the user to free resources if they have overrided the destroy function
+			if (OnUserDestroy())
+			{
+				// User has permitted destroy, so exit and clean up. The screen
+				// buffer itself is released by the destructor
+#ifdef _WIN32
+				if (!m_bHeadless)
+					SetConsoleActiveScreenBuffer(m_hOriginalConsole);
+#else
+				RestoreTerminal();
+#endif
+				m_cvGameFinished.notify_one();
+			}
+			else
+			{
+				// User denied destroy for some reason, so continue running
+				m_bAtomActive = true;
+			}
+		}
+	}
+
+	void HandleInput(float fElapsedTime)
+	{
+		// Handle Keyboard Input
+#ifdef _WIN32
+		for (int i = 0; i < 256; i++)
+			m_keyNewState[i] = GetAsyncKeyState(i);
+#else
+		ReadTerminalKeys(fElapsedTime);
+#endif
+		for (int i = 0; i < 256; i++)
+		{
+			m_keys[i].bPressed = false;
+			m_keys[i].bReleased = false;
 
-					m_keyOldState[i] = m_keyNewState[i];
+			if (m_keyNewState[i] != m_keyOldState[i])
+			{
+				if (m_keyNewState[i] & 0x8000)
+				{
+					m_keys[i].bPressed = !m_keys[i].bHeld;
+					m_keys[i].bHeld = true;
+				}
+				else
+				{
+					m_keys[i].bReleased = true;
+					m_keys[i].bHeld = false;
 				}
+			}
+
+			m_keyOldState[i] = m_keyNewState[i];
+		}
+
+#ifdef _WIN32
+		// Handle Mouse Input - Check for window events
+		INPUT_RECORD inBuf[32];
+		DWORD events = 0;
+		GetNumberOfConsoleInputEvents(m_hConsoleIn, &events);
+		if (events > 0)
+			ReadConsoleInput(m_hConsoleIn, inBuf, events, &events);
+
+		// Handle events - we only care about mouse clicks and movement
+		// for now
+		for (DWORD i = 0; i < events; i++)
+		{
+			switch (inBuf[i].EventType)
+			{
+			case FOCUS_EVENT:
+			{
+				m_bConsoleInFocus = inBuf[i].Event.FocusEvent.bSetFocus;
+			}
+			break;
 
-				// Handle Mouse Input - Check for window events
-				INPUT_RECORD inBuf[32];
-				DWORD events = 0;
-				GetNumberOfConsoleInputEvents(m_hConsoleIn, &events);
-				if (events > 0)
-					ReadConsoleInput(m_hConsoleIn, inBuf, events, &events);
+			case MOUSE_EVENT:
+			{
+				switch (inBuf[i].Event.MouseEvent.dwEventFlags)
+				{
+				case MOUSE_MOVED:
+				{
+					m_mousePosX = inBuf[i].Event.MouseEvent.dwMousePosition.X;
+					m_mousePosY = inBuf[i].Event.MouseEvent.dwMousePosition.Y;
+				}
+				break;
 
-				// Handle events - we only care about mouse clicks and movement
-				// for now
-				for (DWORD i = 0; i < events; i++)
+				case 0:
 				{
-					switch (inBuf[i].EventType)
-					{
-					case FOCUS_EVENT:
-					{
-						m_bConsoleInFocus = inBuf[i].Event.FocusEvent.bSetFocus;
-					}
+					for (int m = 0; m < 5; m++)
+						m_mouseNewState[m] = (inBuf[i].Event.MouseEvent.dwButtonState & (1 << m)) > 0;
+
+				}
+				break;
+
+				default:
 					break;
+				}
+			}
+			break;
 
-					case MOUSE_EVENT:
-					{
-						switch (inBuf[i].Event.MouseEvent.dwEventFlags)
-						{
-						case MOUSE_MOVED:
-						{
-							m_mousePosX = inBuf[i].Event.MouseEvent.dwMousePosition.X;
-							m_mousePosY = inBuf[i].Event.MouseEvent.dwMousePosition.Y;
-						}
-						break;
+			default:
+				break;
+				// We don't care just at the moment
+			}
+		}
 
-						case 0:
-						{
-							for (int m = 0; m < 5; m++)
-								m_mouseNewState[m] = (inBuf[i].Event.MouseEvent.dwButtonState & (1 << m)) > 0;
+		for (int m = 0; m < 5; m++)
+		{
+			m_mouse[m].bPressed = false;
+			m_mouse[m].bReleased = false;
 
-						}
-						break;
+			if (m_mouseNewState[m] != m_mouseOldState[m])
+			{
+				if (m_mouseNewState[m])
+				{
+					m_mouse[m].bPressed = true;
+					m_mouse[m].bHeld = true;
+				}
+				else
+				{
+					m_mouse[m].bReleased = true;
+					m_mouse[m].bHeld = false;
+				}
+			}
+
+			m_mouseOldState[m] = m_mouseNewState[m];
+		}
+#endif
+	}
 
-						default:
-							break;
-						}
+#ifndef _WIN32
+	// A terminal only says which keys were typed, never when one is let go, so
+	// a key counts as held until TERMINAL_KEY_HOLD seconds after its last byte.
+	// Keyboard repeat tops that up for as long as it's held down, once the
+	// repeat delay is over
+	static constexpr float TERMINAL_KEY_HOLD = 0.1f;
+
+	// An arrow key is three bytes, ESC [ A, which a slow link can split across
+	// reads. An ESC or ESC [ at the end of a read is kept to go in front of the
+	// next, and only taken for the Escape key on its own once nothing has
+	// followed it for this long
+	static constexpr float TERMINAL_ESCAPE_WAIT = 0.25f;
+
+	void ReadTerminalKeys(float fElapsedTime)
+	{
+		for (int i = 0; i < 256; i++)
+			m_fKeyHold[i] -= fElapsedTime;
+		if (m_nTermPending > 0)
+			m_fTermPendingAge += fElapsedTime;
+
+		unsigned char buf[64 + sizeof(m_termPending)];
+		for (;;)
+		{
+			memcpy(buf, m_termPending, m_nTermPending);
+			ssize_t n = m_bTerminal ? read(STDIN_FILENO, buf + m_nTermPending, sizeof(buf) - m_nTermPending) : 0;
+			if (n <= 0)
+				break;
+			n += m_nTermPending;
+			m_nTermPending = 0;
+
+			for (ssize_t i = 0; i < n; i++)
+			{
+				unsigned char b = buf[i];
+				int k = 0;
+				if (b == 0x1b && (i + 1 == n || (i + 2 == n && (buf[i + 1] == '[' || buf[i + 1] == 'O'))))
+				{
+					m_nTermPending = (int)(n - i);
+					memcpy(m_termPending, buf + i, m_nTermPending);
+					m_fTermPendingAge = 0.0f;
+					break;
+				}
+				if (b == 0x1b && i + 2 < n && (buf[i + 1] == '[' || buf[i + 1] == 'O'))
+				{
+					switch (buf[i + 2])
+					{
+					case 'A': k = VK_UP; break;
+					case 'B': k = VK_DOWN; break;
+					case 'C': k = VK_RIGHT; break;
+					case 'D': k = VK_LEFT; break;
 					}
+					i += 2;
+				}
+				else if (b == 0x1b)
+					k = VK_ESCAPE;
+				else if (b >= 'a' && b <= 'z')
+					k = b - 'a' + 'A';
+				else if ((b >= 'A' && b <= 'Z') || (b >= '0' && b <= '9') || b == ' ')
+					k = b;
+				else if (b == '\r' || b == '\n')
+					k = VK_RETURN;
+				else if (b == 0x7f || b == 0x08)
+					k = VK_BACK;
+				else if (b == '\t')
+					k = VK_TAB;
+
+				if (k != 0)
+					m_fKeyHold[k] = TERMINAL_KEY_HOLD;
+			}
+		}
+
+		if (m_nTermPending > 0 && m_fTermPendingAge >= TERMINAL_ESCAPE_WAIT)
+		{
+			m_fKeyHold[VK_ESCAPE] = TERMINAL_KEY_HOLD;
+			m_nTermPending = 0;
+		}
+
+		for (int i = 0; i < 256; i++)
+			m_keyNewState[i] = m_fKeyHold[i] > 0.0f ? (short)0x8000 : 0;
+	}
+
+	static void TerminalInterrupt(int)
+	{
+		m_bAtomActive = false;
+	}
+
+	// Write it all, however many calls that takes, counting them
+	static void TerminalWrite(const char *p, size_t n, int &nWrites)
+	{
+		while (n > 0)
+		{
+			ssize_t w = write(STDOUT_FILENO, p, n);
+			nWrites++;
+			if (w < 0 && errno == EINTR)
+				continue;
+			if (w <= 0)
+				return;
+			p += w;
+			n -= (size_t)w;
+		}
+	}
+
+	// Put the terminal back the way ConstructTerminal() found it
+	void RestoreTerminal()
+	{
+		if (m_bTerminalSetUp)
+		{
+			static const char sRestore[] = "\x1b[0m\x1b[?7h\x1b[?25h\x1b[?1049l";
+			int nWrites = 0;
+			TerminalWrite(sRestore, sizeof(sRestore) - 1, nWrites);
+			m_bTerminalSetUp = false;
+		}
+		if (m_bTermiosSaved)
+		{
+			tcsetattr(STDIN_FILENO, TCSANOW, &m_termiosOriginal);
+			m_bTermiosSaved = false;
+		}
+	}
+#endif
+
+	// A run of cells [x1, x2) along row y that changed since the last frame
+	// presented
+	struct sDirtyRun
+	{
+		short y, x1, x2;
+	};
+
+	// Runs closer together than this many unchanged cells are joined, as
+	// every separate write costs more than a few extra cells do
+	static const int PRESENT_RUN_GAP = 8;
+
+	static bool SameCell(const CHAR_INFO &a, const CHAR_INFO &b)
+	{
+		return a.Char.UnicodeChar == b.Char.UnicodeChar && a.Attributes == b.Attributes;
+	}
+
+	// A run and the gap after it are at least PRESENT_RUN_GAP + 1 cells, bar
+	// the last in a row
+	size_t MaxDirtyRuns()
+	{
+		return (size_t)m_nScreenHeight * (m_nScreenWidth / (PRESENT_RUN_GAP + 1) + 1);
+	}
+
+	// Everything presenting needs is allocated before the first frame, as a
+	// present thread runs alongside frames that mustn't allocate
+	void CreatePresentBuffers()
+	{
+		if (m_bufPresented == nullptr)
+			m_bufPresented = new CHAR_INFO[m_nScreenWidth * m_nScreenHeight];
+		m_bPresentAll = true;
+		m_vecDirtyRuns.reserve(MaxDirtyRuns());
+		if (m_bTerminal)
+			m_vecTerminalOut.resize(TerminalBufferSize());
+	}
+
+	// Compare the frame with the last one presented, a row at a time, and
+	// collect the runs of cells that changed into m_vecDirtyRuns
+	void FindDirtyRuns(const CHAR_INFO *pFrame)
+	{
+		m_vecDirtyRuns.clear();
+		for (int y = 0; y < m_nScreenHeight; y++)
+		{
+			const CHAR_INFO *pNew = pFrame + y * m_nScreenWidth;
+			const CHAR_INFO *pOld = m_bufPresented + y * m_nScreenWidth;
+			if (m_bPresentAll)
+			{
+				m_vecDirtyRuns.push_back({ (short)y, 0, (short)m_nScreenWidth });
+				continue;
+			}
+			if (memcmp(pNew, pOld, m_nScreenWidth * sizeof(CHAR_INFO)) == 0)
+				continue;
+
+			int x = 0;
+			while (x < m_nScreenWidth)
+			{
+				while (x < m_nScreenWidth && SameCell(pNew[x], pOld[x]))
+					x++;
+				if (x == m_nScreenWidth)
 					break;
 
-					default:
-						break;
-						// We don't care just at the moment
-					}
+				int x1 = x, x2 = x + 1;
+				for (x = x2; x < m_nScreenWidth && x - x2 < PRESENT_RUN_GAP; x++)
+					if (!SameCell(pNew[x], pOld[x]))
+						x2 = x + 1;
+				m_vecDirtyRuns.push_back({ (short)y, (short)x1, (short)x2 });
+				x = x2;
+			}
+		}
+	}
+
+	// Write the dirty runs to the Win32 console. Runs on consecutive rows go
+	// out as one rectangle around them all
+	void PresentConsole(const CHAR_INFO *pFrame)
+	{
+		size_t r = 0;
+		while (r < m_vecDirtyRuns.size())
+		{
+			SMALL_RECT rect = { m_vecDirtyRuns[r].x1, m_vecDirtyRuns[r].y, (short)(m_vecDirtyRuns[r].x2 - 1), m_vecDirtyRuns[r].y };
+			for (r++; r < m_vecDirtyRuns.size() && m_vecDirtyRuns[r].y <= rect.Bottom + 1; r++)
+			{
+				rect.Left = std::min(rect.Left, m_vecDirtyRuns[r].x1);
+				rect.Right = std::max(rect.Right, (short)(m_vecDirtyRuns[r].x2 - 1));
+				rect.Bottom = m_vecDirtyRuns[r].y;
+			}
+#ifdef _WIN32
+			if (!m_bHeadless)
+				WriteConsoleOutput(m_hConsole, pFrame, { (short)m_nScreenWidth, (short)m_nScreenHeight }, { rect.Left, rect.Top }, &rect);
+#else
+			(void)pFrame;
+#endif
+			m_presentWork.nWrites++;
+			m_presentWork.nBytes += (size_t)(rect.Right - rect.Left + 1) * (rect.Bottom - rect.Top + 1) * sizeof(CHAR_INFO);
+		}
+	}
+
+	// The most bytes one frame of the VT stream can take: every cell changing
+	// both colours (ESC[97;107m) and needing three bytes of UTF-8, a cursor
+	// move (ESC[yyyyy;xxxxxH) for every run a row can hold, and the title
+	size_t TerminalBufferSize()
+	{
+		return (size_t)m_nScreenWidth * m_nScreenHeight * 13 + MaxDirtyRuns() * 14 + 256;
+	}
+
+	static char *TerminalNumber(char *p, int n)
+	{
+		char digits[10];
+		int i = 0;
+		do
+		{
+			digits[i++] = (char)('0' + n % 10);
+			n /= 10;
+		} while (n > 0);
+		while (i > 0)
+			*p++ = digits[--i];
+		return p;
+	}
+
+	// The glyph as UTF-8
+	static char *TerminalGlyph(char *p, unsigned short c)
+	{
+		if (c < 0x80)
+			*p++ = (char)c;
+		else if (c < 0x800)
+		{
+			*p++ = (char)(0xC0 | (c >> 6));
+			*p++ = (char)(0x80 | (c & 0x3F));
+		}
+		else
+		{
+			*p++ = (char)(0xE0 | (c >> 12));
+			*p++ = (char)(0x80 | ((c >> 6) & 0x3F));
+			*p++ = (char)(0x80 | (c & 0x3F));
+		}
+		return p;
+	}
+
+	// Draw the glyph just drawn nRepeat more times, with ESC[nb where that's
+	// shorter than the glyphs themselves
+	char *TerminalRepeat(char *p, unsigned short c, int nRepeat)
+	{
+		int nGlyphBytes = c < 0x80 ? 1 : c < 0x800 ? 2 : 3;
+		int nDigits = nRepeat < 10 ? 1 : nRepeat < 100 ? 2 : nRepeat < 1000 ? 3 : 4;
+		if (m_bTerminalRepeat && 3 + nDigits < nRepeat * nGlyphBytes)
+		{
+			*p++ = '\x1b'; *p++ = '[';
+			p = TerminalNumber(p, nRepeat);
+			*p++ = 'b';
+			return p;
+		}
+		while (nRepeat-- > 0)
+			p = TerminalGlyph(p, c);
+		return p;
+	}
+
+	// Turn the dirty runs into VT escape sequences in one buffer and write it
+	// with a single write(). The cursor is only moved across gaps between runs,
+	// and colours only change when a cell needs different ones from the cell
+	// before. A space only shows its background and a solid block only its
+	// foreground, so the other colour is left as it is
+	void PresentTerminal(const CHAR_INFO *pFrame)
+	{
+		// Console colour bits are blue, green, red; VT's are red, green, blue
+		static const int nAnsi[8] = { 0, 4, 2, 6, 1, 5, 3, 7 };
+
+		if (m_vecTerminalOut.empty())
+			m_vecTerminalOut.resize(TerminalBufferSize());
+		char *pStart = m_vecTerminalOut.data();
+		char *p = pStart;
+
+		// The first frame can't assume anything about the terminal's state
+		if (m_bPresentAll)
+		{
+			*p++ = '\x1b'; *p++ = ']'; *p++ = '0'; *p++ = ';';
+			for (size_t i = 0; i < m_sAppName.size() && i < 64; i++)
+				p = TerminalGlyph(p, (unsigned short)std::min<unsigned>(m_sAppName[i], 0xFFFF));
+			*p++ = '\x07';
+			m_nTerminalFg = m_nTerminalBg = -1;
+			m_nTerminalX = m_nTerminalY = -1;
+		}
+
+		for (const sDirtyRun &run : m_vecDirtyRuns)
+		{
+			if (run.y != m_nTerminalY || run.x1 != m_nTerminalX)
+			{
+				*p++ = '\x1b'; *p++ = '[';
+				if (run.y == m_nTerminalY && m_nTerminalX >= 0 && run.x1 > m_nTerminalX)
+				{
+					p = TerminalNumber(p, run.x1 - m_nTerminalX);
+					*p++ = 'C';
+				}
+				else
+				{
+					p = TerminalNumber(p, run.y + 1);
+					*p++ = ';';
+					p = TerminalNumber(p, run.x1 + 1);
+					*p++ = 'H';
 				}
+			}
+
+			const CHAR_INFO *pCell = pFrame + run.y * m_nScreenWidth + run.x1;
+			unsigned short cLast = 0;
+			int nRepeat = 0;
+			for (int x = run.x1; x < run.x2; x++, pCell++)
+			{
+				unsigned short c = pCell->Char.UnicodeChar ? pCell->Char.UnicodeChar : L' ';
+				int nFg = pCell->Attributes & 0x0F;
+				int nBg = (pCell->Attributes >> 4) & 0x0F;
+				bool bFg = c != L' ' && nFg != m_nTerminalFg;
+				bool bBg = c != PIXEL_SOLID && nBg != m_nTerminalBg;
 
-				for (int m = 0; m < 5; m++)
+				if (!bFg && !bBg && x > run.x1 && c == cLast)
 				{
-					m_mouse[m].bPressed = false;
-					m_mouse[m].bReleased = false;
+					nRepeat++;
+					continue;
+				}
+				p = TerminalRepeat(p, cLast, nRepeat);
+				nRepeat = 0;
 
-					if (m_mouseNewState[m] != m_mouseOldState[m])
+				if (bFg || bBg)
+				{
+					*p++ = '\x1b'; *p++ = '[';
+					if (bFg)
 					{
-						if (m_mouseNewState[m])
-						{
-							m_mouse[m].bPressed = true;
-							m_mouse[m].bHeld = true;
-						}
-						else
-						{
-							m_mouse[m].bReleased = true;
-							m_mouse[m].bHeld = false;
-						}
+						p = TerminalNumber(p, (nFg & 8 ? 90 : 30) + nAnsi[nFg & 7]);
+						m_nTerminalFg = nFg;
 					}
-
-					m_mouseOldState[m] = m_mouseNewState[m];
+					if (bBg)
+					{
+						if (bFg)
+							*p++ = ';';
+						p = TerminalNumber(p, (nBg & 8 ? 100 : 40) + nAnsi[nBg & 7]);
+						m_nTerminalBg = nBg;
+					}
+					*p++ = 'm';
 				}
+				p = TerminalGlyph(p, c);
+				cLast = c;
+			}
+			p = TerminalRepeat(p, cLast, nRepeat);
 
+			// Without wrapping the cursor sticks at the last column, so where
+			// it is after a run that reached it isn't the cell after
+			m_nTerminalY = run.y;
+			m_nTerminalX = run.x2 < m_nScreenWidth ? run.x2 : -1;
+		}
 
-				// Handle Frame Update
-				if (!OnUserUpdate(fElapsedTime))
-					m_bAtomActive = false;
+		size_t nBytes = (size_t)(p - pStart);
+		m_presentWork.nBytes = nBytes;
+		if (nBytes == 0)
+			return;
+#ifndef _WIN32
+		if (!m_bHeadless)
+		{
+			TerminalWrite(pStart, nBytes, m_presentWork.nWrites);
+			return;
+		}
+#endif
+		m_presentWork.nWrites = 1;
+	}
 
-				// Update Title & Present Screen Buffer
-				wchar_t s[256];
-				swprintf_s(s, 256, L"OneLoneCoder.com - Console Game Engine - %s - FPS: %3.2f", m_sAppName.c_str(), 1.0f / fElapsedTime);
-				SetConsoleTitle(s);
-				WriteConsoleOutput(m_hConsole, m_bufScreen, { (short)m_nScreenWidth, (short)m_nScreenHeight }, { 0,0 }, &m_rectWindow);
+	// Send the cells that changed since the last frame to the console or the
+	// terminal. The first frame is sent whole, as there's no telling what's
+	// there before
+	void Present(const CHAR_INFO *pFrame, float fElapsedTime)
+	{
+		FindDirtyRuns(pFrame);
+
+		m_presentWork = sPresentStats();
+		if (m_bTerminal)
+			PresentTerminal(pFrame);
+		else
+			PresentConsole(pFrame);
+
+		// What's on the console now
+		for (const sDirtyRun &run : m_vecDirtyRuns)
+		{
+			size_t nOffset = run.y * m_nScreenWidth + run.x1;
+			memcpy(m_bufPresented + nOffset, pFrame + nOffset, (run.x2 - run.x1) * sizeof(CHAR_INFO));
+			m_presentWork.nCells += run.x2 - run.x1;
+		}
+		m_presentWork.nRuns = (int)m_vecDirtyRuns.size();
+		m_bPresentAll = false;
+		{
+			std::lock_guard<std::mutex> lock(m_muxPresent);
+			m_presentStats = m_presentWork;
+		}
+
+#ifdef _WIN32
+		if (!m_bHeadless && !m_bTerminal)
+		{
+			wchar_t s[256];
+			swprintf_s(s, 256, L"OneLoneCoder.com - Console Game Engine - %s - FPS: %3.2f", m_sAppName.c_str(), 1.0f / fElapsedTime);
+			SetConsoleTitle(s);
+		}
+#else
+		(void)fElapsedTime;
+#endif
+	}
+
+	void CreateScreenBuffers()
+	{
+		for (CHAR_INFO *&buf : m_bufScreens)
+		{
+			buf = new CHAR_INFO[m_nScreenWidth*m_nScreenHeight];
+			memset(buf, 0, sizeof(CHAR_INFO) * m_nScreenWidth * m_nScreenHeight);
+		}
+		m_bufScreen = m_bufScreens[m_nDrawSlot];
+	}
+
+	// The buffers change hands through atomics alone. The mutex and condition
+	// variable are only there for a thread with nothing to do to sleep on
+	void WakePresentThreads()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_muxPresent);
+		}
+		m_cvPresent.notify_all();
+	}
+
+	bool FramePending()
+	{
+		if (m_nPresentMode == PRESENT_LATEST)
+			return (m_nReadySlot.load(std::memory_order_acquire) & PRESENT_FRESH) != 0;
+		return m_nFramesShown.load(std::memory_order_acquire) != m_nFramesSubmitted.load(std::memory_order_acquire);
+	}
+
+	// Hand the frame just drawn to the present thread and carry on in another
+	// buffer, copying the frame into it first so drawing goes on from where
+	// it left off, just as it does with a single buffer
+	void SubmitFrame(float fElapsedTime)
+	{
+		const CHAR_INFO *pDone = m_bufScreen;
+		m_fSlotElapsed[m_nDrawSlot] = fElapsedTime;
+
+		if (m_nPresentMode == PRESENT_LATEST)
+		{
+			// Swap with the frame waiting to be shown, dropping it if it's
+			// still there
+			int nWaiting = m_nReadySlot.exchange(m_nDrawSlot | PRESENT_FRESH, std::memory_order_acq_rel);
+			if (nWaiting & PRESENT_FRESH)
+				m_nFramesDropped++;
+			m_nDrawSlot = nWaiting & PRESENT_SLOT;
+			WakePresentThreads();
+		}
+		else
+		{
+			// Frame n is drawn into buffer n % 3, which is only free again
+			// once frame n - 3 has been shown
+			uint32_t nSubmitted = m_nFramesSubmitted.fetch_add(1, std::memory_order_acq_rel) + 1;
+			WakePresentThreads();
+			m_nDrawSlot = nSubmitted % 3;
+			if (nSubmitted - m_nFramesShown.load(std::memory_order_acquire) >= 3)
+			{
+				std::unique_lock<std::mutex> lock(m_muxPresent);
+				m_cvPresent.wait(lock, [&] { return nSubmitted - m_nFramesShown.load(std::memory_order_acquire) < 3; });
 			}
+		}
 
-			if (m_bEnableSound)
+		m_bufScreen = m_bufScreens[m_nDrawSlot];
+		memcpy(m_bufScreen, pDone, sizeof(CHAR_INFO) * m_nScreenWidth * m_nScreenHeight);
+	}
+
+	// Present frames as they're handed over, until told to stop and there are
+	// none left
+	void PresentThread()
+	{
+		for (;;)
+		{
 			{
-				// Close and Clean up audio system
+				std::unique_lock<std::mutex> lock(m_muxPresent);
+				m_cvPresent.wait(lock, [&] { return m_bPresentQuit || FramePending(); });
 			}
+			if (!FramePending())
+				return;
 
-			// Allow the user to free resources if they have overrided the destroy function
-			if (OnUserDestroy())
+			if (m_nPresentMode == PRESENT_LATEST)
 			{
-				// User has permitted destroy, so exit and clean up
-				delete[] m_bufScreen;
-				SetConsoleActiveScreenBuffer(m_hOriginalConsole);
-				m_cvGameFinished.notify_one();
+				m_nShownSlot = m_nReadySlot.exchange(m_nShownSlot, std::memory_order_acq_rel) & PRESENT_SLOT;
+				Present(m_bufScreens[m_nShownSlot], m_fSlotElapsed[m_nShownSlot]);
 			}
 			else
 			{
-				// User denied destroy for some reason, so continue running
-				m_bAtomActive = true;
+				int nSlot = m_nFramesShown.load(std::memory_order_relaxed) % 3;
+				Present(m_bufScreens[nSlot], m_fSlotElapsed[nSlot]);
+				m_nFramesShown.fetch_add(1, std::memory_order_acq_rel);
+				WakePresentThreads();
 			}
 		}
 	}
@@ -989,6 +2264,7 @@ public:
 
 protected: // Audio Engine =====================================================================
 
+#ifdef _WIN32
 	class olcAudioSample
 	{
 	public:
@@ -1331,7 +2607,13 @@ protected: // Audio Engine =====================================================
 	std::condition_variable m_cvBlockNotZero;
 	std::mutex m_muxBlockNotZero;
 	std::atomic<float> m_fGlobalTime = 0.0f;
-
+#else
+	// No audio device without winmm, so sound can never be enabled
+	bool CreateAudio()
+	{
+		return false;
+	}
+#endif
 	
 
 protected:
@@ -1358,13 +2640,18 @@ public:
 protected:
 	int Error(const wchar_t *msg)
 	{
+#ifdef _WIN32
 		wchar_t buf[256];
 		FormatMessage(FORMAT_MESSAGE_FROM_SYSTEM, NULL, GetLastError(), MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT), buf, 256, NULL);
 		SetConsoleActiveScreenBuffer(m_hOriginalConsole);
 		wprintf(L"ERROR: %s\n\t%s\n", msg, buf);
+#else
+		fprintf(stderr, "ERROR: %ls\n", msg);
+#endif
 		return 0;
 	}
 
+#ifdef _WIN32
 	static BOOL CloseHandler(DWORD evt)
 	{
 		// Note this gets called in a seperate OS thread, so it must
@@ -1380,16 +2667,48 @@ protected:
 		}
 		return true;
 	}
+#endif
 
 protected:
 	int m_nScreenWidth;
 	int m_nScreenHeight;
-	CHAR_INFO *m_bufScreen;
+	CHAR_INFO *m_bufScreen = nullptr;		// the one of m_bufScreens being drawn
+	CHAR_INFO *m_bufScreens[3] = { nullptr, nullptr, nullptr };
+	CHAR_INFO *m_bufPresented = nullptr;	// the frame on the console, as of the last Present()
+	bool m_bPresentAll = true;
+	std::vector<sDirtyRun> m_vecDirtyRuns;
+	sPresentStats m_presentWork;			// filled in by Present()
+	sPresentStats m_presentStats;			// and copied here, under m_muxPresent, when it's done
+
+	// Which buffer is which. The game thread draws into m_nDrawSlot and the
+	// present thread shows m_nShownSlot. With PRESENT_LATEST, m_nReadySlot is
+	// the third, with PRESENT_FRESH set while it holds a frame not yet shown.
+	// With PRESENT_FIFO the frame counts say which buffer is which instead
+	static const int PRESENT_SLOT = 0x3;
+	static const int PRESENT_FRESH = 0x4;
+	int m_nPresentMode = -1;				// -1 until Start() picks the default
+	int m_nDrawSlot = 0;
+	int m_nShownSlot = 2;
+	std::atomic<int> m_nReadySlot{ 1 };
+	std::atomic<uint32_t> m_nFramesSubmitted{ 0 };
+	std::atomic<uint32_t> m_nFramesShown{ 0 };
+	std::atomic<int> m_nFramesDropped{ 0 };
+	float m_fSlotElapsed[3] = { 0.0f, 0.0f, 0.0f };
+	std::thread m_thPresent;
+	std::mutex m_muxPresent;
+	std::condition_variable m_cvPresent;
+	bool m_bPresentQuit = false;
+	float *m_bufDepth = nullptr;	// one per screen cell, only created by ClearDepth()
+	bool m_bHalfSpaceRaster = false;
+	bool m_bCountCellsFilled = false;
+	std::atomic<int64_t> m_nCellsFilled{ 0 };
 	std::wstring m_sAppName;
+#ifdef _WIN32
 	HANDLE m_hOriginalConsole;
 	CONSOLE_SCREEN_BUFFER_INFO m_OriginalConsoleInfo;
 	HANDLE m_hConsole;
 	HANDLE m_hConsoleIn;
+#endif
 	SMALL_RECT m_rectWindow;
 	short m_keyOldState[256] = { 0 };
 	short m_keyNewState[256] = { 0 };
@@ -1397,6 +2716,24 @@ protected:
 	bool m_mouseNewState[5] = { 0 };
 	bool m_bConsoleInFocus = true;	
 	bool m_bEnableSound = false;
+	bool m_bHeadless = false;
+	int m_nFrameLimit = 0;
+	int m_nFrameCount = 0;
+
+	bool m_bTerminal = false;			// present as a VT escape stream
+	bool m_bTerminalRepeat = false;
+	std::vector<char> m_vecTerminalOut;	// one frame of it, sized once
+	int m_nTerminalFg = -1, m_nTerminalBg = -1;	// colours the terminal is drawing in, -1 if unknown
+	int m_nTerminalX = -1, m_nTerminalY = -1;	// and where its cursor is
+#ifndef _WIN32
+	bool m_bTerminalSetUp = false;
+	bool m_bTermiosSaved = false;
+	struct termios m_termiosOriginal;
+	float m_fKeyHold[256] = { 0 };
+	unsigned char m_termPending[2];	// the start of an escape sequence the last read cut off
+	int m_nTermPending = 0;
+	float m_fTermPendingAge = 0.0f;
+#endif
 
 	// These need to be static because of the OnDestroy call the OS may make. The OS
 	// spawns a special thread just for that
@@ -0,0 +1,1090 @@
+#pragma once
+
+#include "olcConsoleGameEngine.h"
+#include "Profiler.h"
+#include "Geometry3D.h"
+#include "ObjLoader.h"
+#include "MeshCache.h"
+#include "TransformKernels.h"
+#include "WorkerPool.h"
+#include "TileBins.h"
+#include "Clipper.h"
+#include "Bvh.h"
+#include "Terrain.h"
+#include "FrameArena.h"
+#include "DepthSort.h"
+#include "AllocCounter.h"
+#include "Shading.h"
+#include <memory>
+#include <algorithm>
+#include <cassert>
+#include <tuple>
+
+// Indexed triangle mesh: each triangle is three consecutive entries in
+// indices. Both are in the order of the BVH over them, which is built once
+// when the OBJ is loaded and kept in the cache with them
+struct Mesh {
+    MeshArray<Vec3d> verts;
+    MeshArray<int> indices;
+    MeshArray<BvhNode> nodes;
+
+    // Size and speed of the last load, for benchmarking
+    ObjLoadStats loadStats;
+    bool bLoadedFromCache = false;
+    
+    bool loadFromObjectFile(std::string sFileName, bool bUseCache = true) {
+        auto tp1 = std::chrono::steady_clock::now();
+        if (bUseCache && MeshCache_Load(sFileName, verts, indices, nodes)) {
+            bLoadedFromCache = true;
+            loadStats = ObjLoadStats();
+            loadStats.nBytes = verts.size() * sizeof(Vec3d) + indices.size() * sizeof(int);
+            loadStats.nVertices = verts.size();
+            loadStats.nTriangles = TriangleCount();
+            loadStats.fSeconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - tp1).count();
+            return true;
+        }
+
+        std::vector<Vec3d> vecVerts;
+        std::vector<int> vecIndices;
+        std::vector<BvhNode> vecNodes;
+        if (!LoadObj(sFileName, vecVerts, vecIndices, &loadStats))
+            return false;
+        Bvh_Build(vecVerts, vecIndices, vecNodes);
+
+        verts.Assign(std::move(vecVerts));
+        indices.Assign(std::move(vecIndices));
+        nodes.Assign(std::move(vecNodes));
+        bLoadedFromCache = false;
+
+        if (bUseCache)
+            MeshCache_Save(sFileName, verts, indices, nodes);
+        return true;
+    }
+
+    size_t TriangleCount() const { return indices.size() / 3; }
+};
+
+
+class olcEngine3D : public olcConsoleGameEngine {
+private: 
+    std::string sMeshFile;
+    bool bUseMeshCache = true;
+    Mesh meshCube;
+    Mat4x4 matProj;
+
+    // The mesh's vertices as SoA streams for the batch transforms, and every
+    // vertex transformed once per frame, triangles index into these. Object
+    // space goes straight to clip space by one matrix, world, view and
+    // projection multiplied together, and then to the screen by one
+    // reciprocal and the viewport step
+    VertexStreams vsObject;
+    VertexStreams vsClip;
+    VertexStreams vsScreen;                 // ClipToScreen of vsClip, w unused
+    std::vector<unsigned> vecOutcodes;      // Clip_Outcode of each vsClip vertex
+    size_t nVerticesTransformed = 0;        // in the last frame
+
+    // The viewport step after the divide: screen = ndc * fViewportScale +
+    // fViewportOffset for both x and y, which also turns them the right way up
+    float fViewportScale = 0.0f;
+    float fViewportOffset = 0.0f;
+
+    // Each triangle's plane in the mesh's own space, with a unit normal,
+    // filled along with vsObject. Back faces are rejected against the eye in
+    // the same space before anything of theirs is looked at, and front faces
+    // are lit by their normal turned into world space, with no square roots
+    std::vector<ClipPlane> vecFacePlanes;
+    Vec3d vEyeObject;       // this frame's camera in the mesh's space
+
+    // The shade each triangle is lit with only changes with matWorld and the
+    // light, not with the camera, so shades are kept from frame to frame in
+    // blocks of BAKE_BLOCK. Each block is stamped with the version of the
+    // inputs it was worked out from, and is only worked out again when it's
+    // drawn and they've changed since
+    static const size_t BAKE_BLOCK = 1024;
+    Vec3d vLightDirection = { 0.0f, 0.1f, -0.1f };
+    Mat4x4 matWorldBaked;
+    Vec3d vLightBaked;      // normalised
+    uint32_t nShadeVersion = 0;
+    std::vector<uint32_t> vecShadeBaked;    // per block of triangles
+    std::vector<uint16_t> vecShade;         // per triangle, Shade_Index()
+    size_t nTrianglesShaded = 0;
+
+    // Planes in clip space. Triangles are clipped against the first six: near,
+    // far, and the four sides of the guard band. The last four are the screen
+    // edges, which triangles are only culled against - without a guard band
+    // the two sets of edges are the same
+    static const int CULL_PLANES = CLIP_MAX_PLANES + 4;
+    static const unsigned CLIP_PLANE_MASK = (1u << CLIP_MAX_PLANES) - 1;
+    ClipPlane clipPlanes[CULL_PLANES];
+
+    // Let triangles reach this many screen widths/heights past each edge of
+    // the screen before clipping them, and scissor them to the screen while
+    // rasterizing instead. Most triangles that cross the screen edge then
+    // don't need clipping at all
+    bool bGuardBand = true;
+    static constexpr float GUARD_BAND = 1.5f;
+
+    // Triangles that needed geometric clipping in the last frame
+    int nTrianglesClipped = 0;
+
+    // Resolve visibility per cell with a depth buffer instead of sorting
+    // triangles and painting them back to front
+    bool bDepthBuffer = false;
+
+    // Threads for the parallel stages below, including the game thread. 0
+    // uses every hardware thread. The pool is started on first use
+    int nThreads = 0;
+    std::unique_ptr<WorkerPool> pool;
+
+    // Transform, light, clip and project the mesh in chunks spread over the
+    // pool, rather than all on the game thread. Either way the frame is the same
+    bool bParallelGeometry = false;
+    static const size_t GEOMETRY_CHUNK = 1024;     // triangles
+    static const size_t TRANSFORM_CHUNK = 4096;    // vertices
+
+    // Cull the mesh's BVH against the view frustum before doing anything per
+    // vertex, then transform and project only the runs of vertices and
+    // triangles that are left. The runs are this frame's, in the arena, and
+    // kept short enough to be jobs for the pool
+    bool bFrustumCulling = true;
+    BvhRange* pTriRanges = nullptr;
+    size_t nTriRanges = 0;
+    BvhRange* pVertRanges = nullptr;
+    size_t nVertRanges = 0;
+    int nTrianglesInView = 0;
+
+    // Draw the mesh as terrain, from a quadtree of chunks at several levels
+    // of detail built the first time it's needed. Each frame draws the
+    // coarsest chunks whose error on screen is no more than fLodError cells
+    bool bTerrainLod = false;
+    float fLodError = 1.0f;
+    Mesh meshTerrain;
+    std::vector<TerrainNode> vecTerrainNodes;
+    const Mesh* pStreamMesh = nullptr;      // the mesh vsObject holds
+
+    // Rasterize in screen tiles spread over the pool, instead of one triangle
+    // at a time on the game thread. Either way the frame is the same
+    bool bTiledRaster = false;
+    TileBins tiles;
+
+    // Fill each triangle with its shade's 4x4 ordered dither tile rather than
+    // the one cell of it
+    bool bDither = false;
+
+    // Triangles handed to FillTriangle in the last frame, after clipping
+    int nTrianglesDrawn = 0;
+
+    // Everything a frame builds is kept for the next one to reuse, either in
+    // buffers that only ever grow or in the arena, which is reset every frame
+    FrameArena arena;
+
+    // Where each mesh triangle came in the painter's order of the last sorted
+    // frame, valid where vecSortedIn holds that frame's number. And whether
+    // this frame could be sorted starting from that order
+    std::vector<uint32_t> vecSortRank;
+    std::vector<uint32_t> vecSortedIn;
+    uint32_t nSortFrame = 0;
+    size_t nLastSorted = 0;
+    bool bSortCoherent = false;
+
+#ifdef OLC_COUNT_ALLOCS
+    // Every buffer a frame uses is sized by the mesh and these settings, apart
+    // from the arena, which grows with what's in view. So once two frames in a
+    // row have had the same settings, a frame mustn't touch the heap at all
+    // unless the arena had to grow, wherever the camera is
+    typedef std::tuple<bool, bool, bool, bool, bool, bool, bool, bool, float, int, float, float, float, int, int> FrameSettings;
+    FrameSettings lastSettings;
+    int nSettledFrames = 0;
+    uint64_t nFrameAllocs = 0;
+    bool bArenaGrew = false;
+#endif
+
+#ifdef OLC_PROFILE
+    PipelineProfiler profiler;
+#endif
+
+    Vec3d vCamera;
+    Vec3d vLookDir;
+
+    float fTheta = 0.0f;
+    float fYaw = 0.0f;
+
+    Vec3d Vector_Add(Vec3d& v1, Vec3d& v2)
+    {
+        return { v1.x + v2.x, v1.y + v2.y, v1.z + v2.z };
+    }
+
+    Vec3d Vector_Sub(Vec3d& v1, Vec3d& v2)
+    {
+        return { v1.x - v2.x, v1.y - v2.y, v1.z - v2.z };
+    }
+
+    Vec3d Vector_Mul(Vec3d& v1, float k)
+    {
+        return { v1.x * k, v1.y * k, v1.z * k };
+    }
+
+    Vec3d Vector_Div(Vec3d& v1, float k)
+    {
+        return { v1.x / k, v1.y / k, v1.z / k };
+    }
+
+    float Vector_DotProduct(Vec3d& v1, Vec3d& v2)
+    {
+        return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
+    }
+
+    float Vector_Length(Vec3d& v)
+    {
+        return sqrtf(Vector_DotProduct(v, v));
+    }
+
+    Vec3d Vector_Normalise(Vec3d& v)
+    {
+        float l = Vector_Length(v);
+        return { v.x / l, v.y / l, v.z / l };
+    }
+
+    Vec3d Vector_CrossProduct(Vec3d& v1, Vec3d& v2)
+    {
+        Vec3d v;
+        v.x = v1.y * v2.z - v1.z * v2.y;
+        v.y = v1.z * v2.x - v1.x * v2.z;
+        v.z = v1.x * v2.y - v1.y * v2.x;
+        return v;
+    }
+
+    // Whether m's last column is (0, 0, 0, 1), as for rotations, translations
+    // and anything made from them: it leaves w alone
+    bool Matrix_IsAffine(const Mat4x4& m)
+    {
+        return m.m[0][3] == 0.0f && m.m[1][3] == 0.0f && m.m[2][3] == 0.0f && m.m[3][3] == 1.0f;
+    }
+
+    OLC_NO_CONTRACT
+    Vec3d Matrix_MultiplyVector(Mat4x4& m, Vec3d& i)
+    {
+        Vec3d v;
+        v.x = i.x * m.m[0][0] + i.y * m.m[1][0] + i.z * m.m[2][0] + i.w * m.m[3][0];
+        v.y = i.x * m.m[0][1] + i.y * m.m[1][1] + i.z * m.m[2][1] + i.w * m.m[3][1];
+        v.z = i.x * m.m[0][2] + i.y * m.m[1][2] + i.z * m.m[2][2] + i.w * m.m[3][2];
+        if (Matrix_IsAffine(m))
+            v.w = i.w;
+        else
+            v.w = i.x * m.m[0][3] + i.y * m.m[1][3] + i.z * m.m[2][3] + i.w * m.m[3][3];
+        return v;
+    }
+
+    Mat4x4 Matrix_MakeIdentity()
+    {
+        Mat4x4 matrix;
+        matrix.m[0][0] = 1.0f;
+        matrix.m[1][1] = 1.0f;
+        matrix.m[2][2] = 1.0f;
+        matrix.m[3][3] = 1.0f;
+        return matrix;
+    }
+
+    Mat4x4 Matrix_MakeRotationX(float fAngleRad)
+    {
+        Mat4x4 matrix;
+        matrix.m[0][0] = 1.0f;
+        matrix.m[1][1] = cosf(fAngleRad);
+        matrix.m[1][2] = sinf(fAngleRad);
+        matrix.m[2][1] = -sinf(fAngleRad);
+        matrix.m[2][2] = cosf(fAngleRad);
+        matrix.m[3][3] = 1.0f;
+        return matrix;
+    }
+
+    Mat4x4 Matrix_MakeRotationY(float fAngleRad)
+    {
+        Mat4x4 matrix;
+        matrix.m[0][0] = cosf(fAngleRad);
+        matrix.m[0][2] = sinf(fAngleRad);
+        matrix.m[2][0] = -sinf(fAngleRad);
+        matrix.m[1][1] = 1.0f;
+        matrix.m[2][2] = cosf(fAngleRad);
+        matrix.m[3][3] = 1.0f;
+        return matrix;
+    }
+
+    Mat4x4 Matrix_MakeRotationZ(float fAngleRad)
+    {
+        Mat4x4 matrix;
+        matrix.m[0][0] = cosf(fAngleRad);
+        matrix.m[0][1] = sinf(fAngleRad);
+        matrix.m[1][0] = -sinf(fAngleRad);
+        matrix.m[1][1] = cosf(fAngleRad);
+        matrix.m[2][2] = 1.0f;
+        matrix.m[3][3] = 1.0f;
+        return matrix;
+    }
+
+    Mat4x4 Matrix_MakeTranslation(float x, float y, float z)
+    {
+        Mat4x4 matrix;
+        matrix.m[0][0] = 1.0f;
+        matrix.m[1][1] = 1.0f;
+        matrix.m[2][2] = 1.0f;
+        matrix.m[3][3] = 1.0f;
+        matrix.m[3][0] = x;
+        matrix.m[3][1] = y;
+        matrix.m[3][2] = z;
+        return matrix;
+    }
+
+    Mat4x4 Matrix_MakeProjection(float fFovDegrees, float fAspectRatio, float fNear, float fFar)
+    {
+        float fFovRad = 1.0f / tanf(fFovDegrees * 0.5f / 180.0f * 3.14159f);
+        Mat4x4 matrix;
+        matrix.m[0][0] = fAspectRatio * fFovRad;
+        matrix.m[1][1] = fFovRad;
+        matrix.m[2][2] = fFar / (fFar - fNear);
+        matrix.m[3][2] = (-fFar * fNear) / (fFar - fNear);
+        matrix.m[2][3] = 1.0f;
+        matrix.m[3][3] = 0.0f;
+        return matrix;
+    }
+
+    Mat4x4 Matrix_MultiplyMatrix(Mat4x4& m1, Mat4x4& m2)
+    {
+        Mat4x4 matrix;
+
+        // Two affine matrices make another: the last column is known, and the
+        // zeros in m1's last column leave three terms per entry, plus the
+        // translation along the bottom row
+        if (Matrix_IsAffine(m1) && Matrix_IsAffine(m2)) {
+            for (int c = 0; c < 3; c++) {
+                for (int r = 0; r < 4; r++)
+                    matrix.m[r][c] = m1.m[r][0] * m2.m[0][c] + m1.m[r][1] * m2.m[1][c] + m1.m[r][2] * m2.m[2][c];
+                matrix.m[3][c] += m2.m[3][c];
+            }
+            matrix.m[3][3] = 1.0f;
+            return matrix;
+        }
+
+        for (int c = 0; c < 4; c++)
+            for (int r = 0; r < 4; r++)
+                matrix.m[r][c] = m1.m[r][0] * m2.m[0][c] + m1.m[r][1] * m2.m[1][c] + m1.m[r][2] * m2.m[2][c] + m1.m[r][3] * m2.m[3][c];
+        return matrix;
+    }
+
+    Mat4x4 Matrix_PointAt(Vec3d& pos, Vec3d& target, Vec3d& up)
+    {
+        // Calculate new forward direction
+        Vec3d newForward = Vector_Sub(target, pos);
+        newForward = Vector_Normalise(newForward);
+
+        // Calculate new Up direction
+        Vec3d a = Vector_Mul(newForward, Vector_DotProduct(up, newForward));
+        Vec3d newUp = Vector_Sub(up, a);
+        newUp = Vector_Normalise(newUp);
+
+        // New Right direction is easy, its just cross product
+        Vec3d newRight = Vector_CrossProduct(newUp, newForward);
+
+        // Construct Dimensioning and Translation Matrix	
+        Mat4x4 matrix;
+        matrix.m[0][0] = newRight.x;	matrix.m[0][1] = newRight.y;	matrix.m[0][2] = newRight.z;	matrix.m[0][3] = 0.0f;
+        matrix.m[1][0] = newUp.x;		matrix.m[1][1] = newUp.y;		matrix.m[1][2] = newUp.z;		matrix.m[1][3] = 0.0f;
+        matrix.m[2][0] = newForward.x;	matrix.m[2][1] = newForward.y;	matrix.m[2][2] = newForward.z;	matrix.m[2][3] = 0.0f;
+        matrix.m[3][0] = pos.x;			matrix.m[3][1] = pos.y;			matrix.m[3][2] = pos.z;			matrix.m[3][3] = 1.0f;
+        return matrix;
+
+    }
+
+    Mat4x4 Matrix_QuickInverse(Mat4x4& m) // Only for Rotation/Translation Matrices
+    {
+        Mat4x4 matrix;
+        matrix.m[0][0] = m.m[0][0]; matrix.m[0][1] = m.m[1][0]; matrix.m[0][2] = m.m[2][0]; matrix.m[0][3] = 0.0f;
+        matrix.m[1][0] = m.m[0][1]; matrix.m[1][1] = m.m[1][1]; matrix.m[1][2] = m.m[2][1]; matrix.m[1][3] = 0.0f;
+        matrix.m[2][0] = m.m[0][2]; matrix.m[2][1] = m.m[1][2]; matrix.m[2][2] = m.m[2][2]; matrix.m[2][3] = 0.0f;
+        matrix.m[3][0] = -(m.m[3][0] * matrix.m[0][0] + m.m[3][1] * matrix.m[1][0] + m.m[3][2] * matrix.m[2][0]);
+        matrix.m[3][1] = -(m.m[3][0] * matrix.m[0][1] + m.m[3][1] * matrix.m[1][1] + m.m[3][2] * matrix.m[2][1]);
+        matrix.m[3][2] = -(m.m[3][0] * matrix.m[0][2] + m.m[3][1] * matrix.m[1][2] + m.m[3][2] * matrix.m[2][2]);
+        matrix.m[3][3] = 1.0f;
+        return matrix;
+    }
+
+    WorkerPool& Pool()
+    {
+        if (!pool)
+            pool = std::make_unique<WorkerPool>(nThreads);
+        return *pool;
+    }
+
+    // The mesh being drawn, the terrain's in terrain mode
+    const Mesh& DrawMesh()
+    {
+        return bTerrainLod ? meshTerrain : meshCube;
+    }
+
+    // Build the terrain if it's needed and hasn't been yet, and fill vsObject
+    // from whichever mesh is being drawn if it doesn't hold that one already
+    void PrepareDrawMesh()
+    {
+        if (bTerrainLod && vecTerrainNodes.empty()) {
+            std::vector<Vec3d> vecVerts;
+            std::vector<int> vecIndices;
+            Terrain_Build(meshCube.verts.data(), meshCube.verts.size(), meshCube.indices.data(), meshCube.TriangleCount(),
+                vecVerts, vecIndices, vecTerrainNodes);
+            meshTerrain.verts.Assign(std::move(vecVerts));
+            meshTerrain.indices.Assign(std::move(vecIndices));
+        }
+
+        const Mesh& mesh = DrawMesh();
+        if (pStreamMesh != &mesh) {
+            pStreamMesh = &mesh;
+            vsObject.resize(mesh.verts.size());
+            for (size_t i = 0; i < mesh.verts.size(); i++)
+                vsObject.Set(i, mesh.verts[i]);
+
+            vecShadeBaked.assign((mesh.TriangleCount() + BAKE_BLOCK - 1) / BAKE_BLOCK, 0);
+            vecShade.resize(mesh.TriangleCount());
+
+            vecFacePlanes.resize(mesh.TriangleCount());
+            for (size_t t = 0; t < mesh.TriangleCount(); t++) {
+                Vec3d p0 = mesh.verts[mesh.indices[t * 3]];
+                Vec3d p1 = mesh.verts[mesh.indices[t * 3 + 1]];
+                Vec3d p2 = mesh.verts[mesh.indices[t * 3 + 2]];
+                Vec3d line1 = Vector_Sub(p1, p0);
+                Vec3d line2 = Vector_Sub(p2, p0);
+                Vec3d normal = Vector_CrossProduct(line1, line2);
+                normal = Vector_Normalise(normal);
+                vecFacePlanes[t] = { normal.x, normal.y, normal.z, -Vector_DotProduct(normal, p0) };
+            }
+        }
+    }
+
+    // Work out this frame's runs of vertices and triangles to draw, from the
+    // mesh's BVH or the terrain's quadtree, the object to clip space
+    // transform m and the eye in object space
+    void CullMesh(const Mat4x4& m, const Vec3d& vEye)
+    {
+        const Mesh& mesh = DrawMesh();
+        size_t nNodes = bTerrainLod ? vecTerrainNodes.size() : mesh.nodes.size();
+        size_t nTris = mesh.TriangleCount();
+        size_t nVerts = mesh.verts.size();
+        pTriRanges = arena.Alloc<BvhRange>(Bvh_MaxRanges(nNodes, nTris, GEOMETRY_CHUNK));
+        pVertRanges = arena.Alloc<BvhRange>(Bvh_MaxRanges(nNodes, nVerts, TRANSFORM_CHUNK));
+
+        // Near, far and the screen edges, taken back through m into the
+        // mesh's own space: a point v is inside when (v * m) . p >= 0, which
+        // is v . (m p)
+        ClipPlane planes[6];
+        const ClipPlane* pClip[6] = { &clipPlanes[0], &clipPlanes[1], &clipPlanes[CLIP_MAX_PLANES],
+            &clipPlanes[CLIP_MAX_PLANES + 1], &clipPlanes[CLIP_MAX_PLANES + 2], &clipPlanes[CLIP_MAX_PLANES + 3] };
+        for (int p = 0; p < 6; p++) {
+            const ClipPlane& c = *pClip[p];
+            float q[4];
+            for (int i = 0; i < 4; i++)
+                q[i] = m.m[i][0] * c.a + m.m[i][1] * c.b + m.m[i][2] * c.c + m.m[i][3] * c.d;
+            planes[p] = { q[0], q[1], q[2], q[3] };
+        }
+
+        if (bTerrainLod) {
+            // ClipToScreen scales both x and y by the screen width, so at
+            // distance 1 a unit is this many cells across in the wider of them
+            float fPixelsPerUnit = 0.5f * (float)ScreenWidth() * std::max(matProj.m[0][0], matProj.m[1][1]);
+            uint32_t* pDrawn = arena.Alloc<uint32_t>(nNodes);
+            uint8_t* pGrid = arena.Alloc<uint8_t>(Terrain_GridCells(vecTerrainNodes.data(), nNodes));
+            Terrain_Select(vecTerrainNodes.data(), nNodes, planes, bFrustumCulling ? 6 : 0, vEye, fPixelsPerUnit, fLodError, pDrawn, pGrid,
+                pTriRanges, nTriRanges, GEOMETRY_CHUNK, pVertRanges, nVertRanges, TRANSFORM_CHUNK);
+        }
+        else if (bFrustumCulling)
+            Bvh_Cull(mesh.nodes.data(), nNodes, planes, 6, pTriRanges, nTriRanges, GEOMETRY_CHUNK, pVertRanges, nVertRanges, TRANSFORM_CHUNK);
+        else {
+            nTriRanges = nVertRanges = 0;
+            Bvh_AddRange(pTriRanges, nTriRanges, 0, (uint32_t)nTris, GEOMETRY_CHUNK);
+            Bvh_AddRange(pVertRanges, nVertRanges, 0, (uint32_t)nVerts, TRANSFORM_CHUNK);
+        }
+
+        nTrianglesInView = 0;
+        for (size_t r = 0; r < nTriRanges; r++)
+            nTrianglesInView += pTriRanges[r].nLast - pTriRanges[r].nFirst;
+    }
+
+    // Call job(first, last) for each of this frame's runs of vertices, spread
+    // over the pool in parallel geometry mode
+    template <typename JOB>
+    void ForVertexRanges(JOB job)
+    {
+        if (!bParallelGeometry) {
+            for (size_t r = 0; r < nVertRanges; r++)
+                job((size_t)pVertRanges[r].nFirst, (size_t)pVertRanges[r].nLast);
+            return;
+        }
+
+        Pool().ParallelFor((int)nVertRanges, [&](int n, int) {
+            job((size_t)pVertRanges[n].nFirst, (size_t)pVertRanges[n].nLast);
+        });
+    }
+
+    // Call job(first, last) for each block of BAKE_BLOCK items out of
+    // nCount that this frame's runs touch and that wasn't stamped with
+    // nVersion yet, spread over the pool in parallel geometry mode. Returns
+    // how many items that came to
+    template <typename JOB>
+    size_t BakeBlocks(const BvhRange* pRanges, size_t nRanges, size_t nCount, std::vector<uint32_t>& vecStamps, uint32_t nVersion, JOB job)
+    {
+        uint32_t* pStale = arena.Alloc<uint32_t>(vecStamps.size());
+        size_t nStale = 0;
+        for (size_t r = 0; r < nRanges; r++) {
+            if (pRanges[r].nFirst == pRanges[r].nLast)
+                continue;
+            for (size_t b = pRanges[r].nFirst / BAKE_BLOCK; b <= (pRanges[r].nLast - 1) / BAKE_BLOCK; b++) {
+                if (vecStamps[b] != nVersion) {
+                    vecStamps[b] = nVersion;
+                    pStale[nStale++] = (uint32_t)b;
+                }
+            }
+        }
+
+        auto bake = [&](int n, int) {
+            size_t nFirst = (size_t)pStale[n] * BAKE_BLOCK;
+            job(nFirst, std::min(nFirst + BAKE_BLOCK, nCount));
+        };
+        if (bParallelGeometry)
+            Pool().ParallelFor((int)nStale, bake);
+        else
+            for (size_t n = 0; n < nStale; n++)
+                bake((int)n, 0);
+
+        size_t nItems = nStale * BAKE_BLOCK;
+        if (nStale > 0 && pStale[nStale - 1] == vecStamps.size() - 1)
+            nItems -= vecStamps.size() * BAKE_BLOCK - nCount;
+        return nItems;
+    }
+
+    // Light triangles [nFirst, nLast) with the normals from their planes
+    // turned by matWorld, ignoring its translation
+    void ShadeTriangles(size_t nFirst, size_t nLast)
+    {
+        for (size_t t = nFirst; t < nLast; t++) {
+            const ClipPlane& plane = vecFacePlanes[t];
+            Vec3d normal = { plane.a, plane.b, plane.c, 0.0f };
+            normal = Matrix_MultiplyVector(matWorldBaked, normal);
+            float dotProduct = std::max(0.1f, Vector_DotProduct(vLightBaked, normal));
+            vecShade[t] = Shade_Index(dotProduct);
+        }
+    }
+
+    // out = in * m, for this frame's vertices
+    void TransformVertices(const Mat4x4& m, const VertexStreams& in, VertexStreams& out)
+    {
+        out.resize(in.size());
+        ForVertexRanges([&](size_t nFirst, size_t nLast) { Transform_Range(m, in, out, nFirst, nLast); });
+    }
+
+    // Clip space to screen cells, with depth left in z: one reciprocal, and
+    // the viewport step
+    Vec3d ClipToScreen(const Vec3d& v)
+    {
+        float fInvW = 1.0f / v.w;
+        float fScale = fInvW * fViewportScale;
+        return { v.x * fScale + fViewportOffset, v.y * fScale + fViewportOffset, v.z * fInvW };
+    }
+
+    // vsScreen from vsClip, for this frame's vertices. Vertices behind the eye
+    // come out as nonsense, but every triangle using one is clipped, and
+    // clipping projects what it makes itself
+    void ProjectVertices()
+    {
+        vsScreen.resize(vsClip.size());
+        ForVertexRanges([&](size_t nFirst, size_t nLast) {
+            for (size_t i = nFirst; i < nLast; i++) {
+                Vec3d s = ClipToScreen(vsClip.Get(i));
+                vsScreen.x[i] = s.x;
+                vsScreen.y[i] = s.y;
+                vsScreen.z[i] = s.z;
+            }
+        });
+    }
+
+    // The clip space planes bounding screen cells [x1, x2] x [y1, y2].
+    // ClipToScreen maps both x and y by the screen width, so cell x ends up at
+    // x/w = 1 - 2x/W and likewise for y. That's fViewportScale = -W/2 and
+    // fViewportOffset = W/2, which SetupClipPlanes sets along with the planes
+    void SetupEdgePlanes(ClipPlane* planes, float x1, float y1, float x2, float y2)
+    {
+        float fScale = 2.0f / (float)ScreenWidth();
+        planes[0] = { -1.0f, 0.0f, 0.0f, 1.0f - x1 * fScale };     // left, x <= (1 - 2x1/W)w
+        planes[1] = { 1.0f, 0.0f, 0.0f, -(1.0f - x2 * fScale) };   // right
+        planes[2] = { 0.0f, -1.0f, 0.0f, 1.0f - y1 * fScale };     // top
+        planes[3] = { 0.0f, 1.0f, 0.0f, -(1.0f - y2 * fScale) };   // bottom
+    }
+
+    // The screen edges are at cell W-1 and H-1 as FillTriangle draws its
+    // right and bottom edges
+    void SetupClipPlanes()
+    {
+        float fRight = (float)(ScreenWidth() - 1), fBottom = (float)(ScreenHeight() - 1);
+        float fGuardX = bGuardBand ? GUARD_BAND * (float)ScreenWidth() : 0.0f;
+        float fGuardY = bGuardBand ? GUARD_BAND * (float)ScreenHeight() : 0.0f;
+        fViewportScale = -0.5f * (float)ScreenWidth();
+        fViewportOffset = 0.5f * (float)ScreenWidth();
+
+        clipPlanes[0] = { 0.0f, 0.0f, 1.0f, 0.0f };     // near, z >= 0
+        clipPlanes[1] = { 0.0f, 0.0f, -1.0f, 1.0f };    // far, z <= w
+        SetupEdgePlanes(clipPlanes + 2, -fGuardX, -fGuardY, fRight + fGuardX, fBottom + fGuardY);
+        SetupEdgePlanes(clipPlanes + CLIP_MAX_PLANES, 0.0f, 0.0f, fRight, fBottom);
+    }
+
+    // Cull back faces from triangles [nFirst, nLast) of the mesh, then clip
+    // and project the rest from the transformed vertices with their shades,
+    // writing what's visible to pOut, which must have room for CLIP_MAX_FAN
+    // triangles per mesh triangle.
+    // Only touches its arguments, so ranges can run on different threads, but
+    // then bProfile must be false as the profiler belongs to the game thread
+    // Returns how many triangles it wrote, and adds how many of the mesh's
+    // had to be clipped to nClipped
+    size_t ProjectTriangles(size_t nFirst, size_t nLast, Triangle* pOut, int& nClipped, bool bProfile)
+    {
+        Triangle* pNext = pOut;
+        const int* pIndices = DrawMesh().indices.data() + nFirst * 3;
+        for (size_t t = nFirst; t < nLast; t++, pIndices += 3) {
+            Triangle triProjected;
+
+            // Facing the camera if the eye is in front of the plane
+            const ClipPlane& plane = vecFacePlanes[t];
+            bool bVisible = plane.a * vEyeObject.x + plane.b * vEyeObject.y + plane.c * vEyeObject.z + plane.d > 0.0f;
+            if (bProfile) PROFILE_LAP(profiler, STAGE_BACKFACE);
+
+            if (bVisible)
+            {   
+                CHAR_INFO shade = Shade_Cell(vecShade[t]);
+                triProjected.col = shade.Attributes;
+                triProjected.sym = shade.Char.UnicodeChar;
+                triProjected.shade = vecShade[t];
+
+                // Clip in clip space against every side of the view volume at
+                // once, after dropping anything wholly off one side of it or of
+                // the screen
+                unsigned c0 = vecOutcodes[pIndices[0]], c1 = vecOutcodes[pIndices[1]], c2 = vecOutcodes[pIndices[2]];
+                if (c0 & c1 & c2)
+                {
+                    if (bProfile) PROFILE_LAP(profiler, STAGE_CLIP);
+                    continue;
+                }
+
+                // Most triangles are wholly inside, and their corners are
+                // already on the screen. The rest are clipped, and what that
+                // leaves is projected here
+                Vec3d polygon[CLIP_MAX_VERTS];
+                int nVerts = 3;
+                if ((c0 | c1 | c2) & CLIP_PLANE_MASK)
+                {
+                    nClipped++;
+                    nVerts = Clip_Triangle(clipPlanes, CLIP_MAX_PLANES,
+                        vsClip.Get(pIndices[0]), vsClip.Get(pIndices[1]), vsClip.Get(pIndices[2]),
+                        c0 & CLIP_PLANE_MASK, c1 & CLIP_PLANE_MASK, c2 & CLIP_PLANE_MASK, polygon);
+                    if (bProfile) PROFILE_LAP(profiler, STAGE_CLIP);
+
+                    for (int i = 0; i < nVerts; i++)
+                        polygon[i] = ClipToScreen(polygon[i]);
+                }
+                else
+                {
+                    for (int i = 0; i < 3; i++)
+                        polygon[i] = { vsScreen.x[pIndices[i]], vsScreen.y[pIndices[i]], vsScreen.z[pIndices[i]] };
+                    if (bProfile) PROFILE_LAP(profiler, STAGE_CLIP);
+                }
+
+                // What's left is convex, so it splits into a fan
+                triProjected.nSource = (uint32_t)t;
+                for (int i = 1; i + 1 < nVerts; i++)
+                {
+                    triProjected.p[0] = polygon[0];
+                    triProjected.p[1] = polygon[i];
+                    triProjected.p[2] = polygon[i + 1];
+                    *pNext++ = triProjected;
+                }
+                if (bProfile) PROFILE_LAP(profiler, STAGE_PROJECTION);
+              
+            }
+        }
+        return pNext - pOut;
+    }
+
+    // Put the triangles in painter's order, furthest first by average depth,
+    // and return them in the arena
+    Triangle* SortTriangles(const Triangle* pTris, size_t nTris)
+    {
+        // One pass over the triangles for everything the sort needs from them
+        uint32_t* pTriKeys = arena.Alloc<uint32_t>(nTris);
+        uint32_t* pSources = arena.Alloc<uint32_t>(nTris);
+        for (size_t i = 0; i < nTris; i++) {
+            pTriKeys[i] = DepthSort_Key((pTris[i].p[0].z + pTris[i].p[1].z + pTris[i].p[2].z) / 3.0f);
+            pSources[i] = pTris[i].nSource;
+        }
+
+        uint32_t* pKeys = arena.Alloc<uint32_t>(nTris);
+        uint32_t* pOrder = arena.Alloc<uint32_t>(nTris);
+        uint32_t* pTmpKeys = arena.Alloc<uint32_t>(nTris);
+        uint32_t* pTmpOrder = arena.Alloc<uint32_t>(nTris);
+
+        if (vecSortRank.size() != DrawMesh().TriangleCount()) {
+            vecSortRank.assign(DrawMesh().TriangleCount(), 0);
+            vecSortedIn.assign(DrawMesh().TriangleCount(), 0);
+            nLastSorted = 0;
+        }
+
+        // Lay the triangles drawn last frame out in last frame's order, and
+        // insertion sort them from there. The new ones go at the end, sorted
+        // on their own, and then the two lists are merged. If too much has
+        // moved it's quicker to start over
+        bSortCoherent = false;
+        if (nLastSorted > 0) {
+            uint32_t* pStart = arena.Alloc<uint32_t>(nLastSorted + 1);
+            std::fill(pStart, pStart + nLastSorted + 1, 0);
+
+            size_t nOld = 0;
+            for (size_t i = 0; i < nTris; i++) {
+                uint32_t nSource = pSources[i];
+                if (vecSortedIn[nSource] == nSortFrame) {
+                    pStart[vecSortRank[nSource] + 1]++;
+                    nOld++;
+                }
+            }
+            for (size_t r = 0; r < nLastSorted; r++)
+                pStart[r + 1] += pStart[r];
+
+            size_t nNew = nOld;
+            for (size_t i = 0; i < nTris; i++) {
+                uint32_t nSource = pSources[i];
+                size_t o = vecSortedIn[nSource] == nSortFrame ? pStart[vecSortRank[nSource]]++ : nNew++;
+                pTmpKeys[o] = pTriKeys[i];
+                pTmpOrder[o] = (uint32_t)i;
+            }
+
+            if (DepthSort_Insertion(pTmpKeys, pTmpOrder, nOld, nOld)) {
+                DepthSort_Radix(pTmpKeys + nOld, pTmpOrder + nOld, pKeys, pOrder, nTris - nOld);
+                DepthSort_Merge(pTmpKeys, pTmpOrder, nOld, pTmpKeys + nOld, pTmpOrder + nOld, nTris - nOld, pKeys, pOrder);
+                bSortCoherent = true;
+            }
+        }
+
+        if (!bSortCoherent) {
+            for (size_t i = 0; i < nTris; i++) {
+                pKeys[i] = pTriKeys[i];
+                pOrder[i] = (uint32_t)i;
+            }
+            DepthSort_Radix(pKeys, pOrder, pTmpKeys, pTmpOrder, nTris);
+        }
+
+        Triangle* pSorted = arena.Alloc<Triangle>(nTris);
+        for (size_t i = 0; i < nTris; i++)
+            pSorted[i] = pTris[pOrder[i]];
+
+        // Remember this order for next frame. A mesh triangle clipped into
+        // several goes by the first of them
+        nSortFrame++;
+        for (size_t i = 0; i < nTris; i++) {
+            uint32_t nSource = pSources[pOrder[i]];
+            if (vecSortedIn[nSource] != nSortFrame) {
+                vecSortedIn[nSource] = nSortFrame;
+                vecSortRank[nSource] = (uint32_t)i;
+            }
+        }
+        nLastSorted = nTris;
+        return pSorted;
+    }
+
+    // Draw triangles a tile at a time, each tile on one thread and in the
+    // same triangle order as drawing them one by one
+    void RasterTiles(const Triangle* pTris, size_t nTris)
+    {
+        tiles.Resize(ScreenWidth(), ScreenHeight(), 32);
+
+        // Rounded outwards, the rasterizers clip exactly to the tile anyway
+        auto bounds = [](const Triangle& t, int& x1, int& y1, int& x2, int& y2) {
+            float minx = std::min({ t.p[0].x, t.p[1].x, t.p[2].x }), maxx = std::max({ t.p[0].x, t.p[1].x, t.p[2].x });
+            float miny = std::min({ t.p[0].y, t.p[1].y, t.p[2].y }), maxy = std::max({ t.p[0].y, t.p[1].y, t.p[2].y });
+            x1 = (int)floorf(minx) - 1; y1 = (int)floorf(miny) - 1;
+            x2 = (int)maxx + 1; y2 = (int)maxy + 1;
+        };
+
+        int x1, y1, x2, y2;
+        for (size_t i = 0; i < nTris; i++) {
+            bounds(pTris[i], x1, y1, x2, y2);
+            tiles.Count(x1, y1, x2, y2);
+        }
+        tiles.Place(arena.Alloc<uint32_t>(tiles.Total()));
+        for (size_t i = 0; i < nTris; i++) {
+            bounds(pTris[i], x1, y1, x2, y2);
+            tiles.Add((uint32_t)i, x1, y1, x2, y2);
+        }
+
+        Pool().ParallelFor(tiles.Count(), [&](int nTile, int) {
+            int x1, y1, x2, y2;
+            tiles.Rect(nTile, x1, y1, x2, y2);
+            for (uint32_t i : tiles.Bin(nTile)) {
+                const Triangle& t = pTris[i];
+                const CHAR_INFO* pDither = bDither ? Shade_Dither(t.shade) : nullptr;
+                if (bDepthBuffer)
+                    FillTriangleDepth(t.p[0].x, t.p[0].y, t.p[0].z, t.p[1].x, t.p[1].y, t.p[1].z, t.p[2].x, t.p[2].y, t.p[2].z, t.sym, t.col, x1, y1, x2, y2, pDither);
+                else
+                    FillTriangleClipped(t.p[0].x, t.p[0].y, t.p[1].x, t.p[1].y, t.p[2].x, t.p[2].y, t.sym, t.col, x1, y1, x2, y2, pDither);
+            }
+        });
+    }
+
+
+
+public:
+    olcEngine3D(std::string sMesh = "mountains.obj", bool bMeshCache = true){
+        m_sAppName = L"3D Demo";
+        sMeshFile = sMesh;
+        bUseMeshCache = bMeshCache;
+    }
+
+    void SetDepthBuffer(bool b) { bDepthBuffer = b; }
+    bool DepthBuffer() { return bDepthBuffer; }
+
+    // n includes the game thread, 0 uses every hardware thread
+    void SetThreads(int n) { nThreads = n; pool.reset(); }
+    int Threads() { return Pool().ThreadCount(); }
+
+    void SetParallelGeometry(bool b) { bParallelGeometry = b; }
+    bool ParallelGeometry() { return bParallelGeometry; }
+
+    void SetTiledRaster(bool b) { bTiledRaster = b; }
+    bool TiledRaster() { return bTiledRaster; }
+
+    void SetDither(bool b) { bDither = b; }
+    bool Dither() { return bDither; }
+
+    void SetFrustumCulling(bool b) { bFrustumCulling = b; }
+    bool FrustumCulling() { return bFrustumCulling; }
+    int TrianglesInView() { return nTrianglesInView; }
+
+    void SetTerrainLod(bool b) { bTerrainLod = b; }
+    bool TerrainLod() { return bTerrainLod; }
+    void SetLodError(float f) { fLodError = f; }
+    float LodError() { return fLodError; }
+
+    void SetGuardBand(bool b) { bGuardBand = b; }
+    bool GuardBand() { return bGuardBand; }
+    int TrianglesClipped() { return nTrianglesClipped; }
+
+    int TrianglesDrawn() { return nTrianglesDrawn; }
+    size_t VerticesTransformed() { return nVerticesTransformed; }
+    size_t TrianglesShaded() { return nTrianglesShaded; }
+    void SetLightDirection(const Vec3d& v) { vLightDirection = v; }
+    bool SortWasCoherent() { return bSortCoherent; }
+#ifdef OLC_COUNT_ALLOCS
+    uint64_t FrameAllocations() { return nFrameAllocs; }
+#endif
+    size_t MeshTriangles() { return meshCube.TriangleCount(); }
+    const ObjLoadStats& MeshLoadStats() { return meshCube.loadStats; }
+    bool MeshFromCache() { return meshCube.bLoadedFromCache; }
+#ifdef OLC_PROFILE
+    PipelineProfiler& Profiler() { return profiler; }
+#endif
+
+public:
+    bool OnUserCreate() override{
+
+        if (!meshCube.loadFromObjectFile(sMeshFile, bUseMeshCache))
+            return false;
+
+        PrepareDrawMesh();
+
+        //Projection Matrix
+        matProj = Matrix_MakeProjection(90.f, (float)ScreenHeight()/(float)ScreenWidth(), 0.1f, 1000.0f);
+
+        return true;
+    }
+
+public:
+    bool OnUserUpdate(float fElapsedTime) override {
+        PROFILE_BEGIN_FRAME(profiler);
+#ifdef OLC_COUNT_ALLOCS
+        uint64_t nAllocsBefore = Alloc_Count();
+        size_t nArenaBefore = arena.Capacity();
+#endif
+        arena.Reset();
+
+        if (GetKey(VK_UP).bHeld)
+            vCamera.y += 8.0f * fElapsedTime;
+
+        if (GetKey(VK_DOWN).bHeld)
+            vCamera.y -= 8.0f * fElapsedTime;   
+
+        if (GetKey(VK_RIGHT).bHeld)
+            vCamera.x -= 8.0f * fElapsedTime;
+
+        if (GetKey(VK_LEFT).bHeld)
+            vCamera.x += 8.0f * fElapsedTime;
+
+        Vec3d   vForward = Vector_Mul(vLookDir, 8.0f * fElapsedTime);
+
+        if (GetKey(L'W').bHeld)
+            vCamera = Vector_Add(vCamera, vForward);
+
+        if (GetKey(L'S').bHeld)
+            vCamera = Vector_Sub(vCamera, vForward);
+
+
+        if (GetKey(L'A').bHeld)
+            fYaw -= 2.0f * fElapsedTime;
+
+        if (GetKey(L'D').bHeld)
+            fYaw += 2.0f * fElapsedTime;
+
+        if (GetKey(L'Z').bPressed)
+            bDepthBuffer = !bDepthBuffer;
+
+#ifdef OLC_COUNT_ALLOCS
+        FrameSettings settings(bDepthBuffer, bTiledRaster, bParallelGeometry, bGuardBand, bFrustumCulling, bTerrainLod, bDither, HalfSpaceRaster(),
+            fLodError, nThreads, vLightDirection.x, vLightDirection.y, vLightDirection.z, ScreenWidth(), ScreenHeight());
+        nSettledFrames = settings == lastSettings ? nSettledFrames + 1 : 0;
+        lastSettings = settings;
+#endif
+
+        PrepareDrawMesh();
+
+        PROFILE_MARK(profiler);
+        Clear(PIXEL_SOLID, FG_BLACK);
+        if (bDepthBuffer)
+            ClearDepth();
+        PROFILE_LAP(profiler, STAGE_CLEAR);
+
+        Mat4x4 matRotX, matRotZ;
+        //fTheta += 1.0f * fElapsedTime;
+
+        matRotZ = Matrix_MakeRotationZ(fTheta);
+        matRotX = Matrix_MakeRotationX(fTheta);
+
+        Mat4x4 matTrans;
+        matTrans = Matrix_MakeTranslation(0.0f, 0.0f, 5.0f);
+
+        Mat4x4 matWorld;
+        matWorld = Matrix_MakeIdentity();
+        matWorld = Matrix_MultiplyMatrix(matRotZ, matRotX);
+        matWorld = Matrix_MultiplyMatrix(matWorld, matTrans);
+
+        Vec3d vUp = { 0, 1, 0 };
+        Vec3d vTarget = { 0, 0, 1 };
+        Mat4x4 matCameraRotY = Matrix_MakeRotationY(fYaw);
+        vLookDir = Matrix_MultiplyVector(matCameraRotY, vTarget);
+        vTarget = Vector_Add(vCamera, vLookDir);
+        
+        Mat4x4 matCamera = Matrix_PointAt(vCamera, vTarget, vUp);
+        Mat4x4 matView = Matrix_QuickInverse(matCamera);
+
+
+        PROFILE_MARK(profiler);
+
+        SetupClipPlanes();
+        Mat4x4 matWorldView = Matrix_MultiplyMatrix(matWorld, matView);
+        Mat4x4 matWorldInv = Matrix_QuickInverse(matWorld);
+        vEyeObject = Matrix_MultiplyVector(matWorldInv, vCamera);
+        Mat4x4 matClip = Matrix_MultiplyMatrix(matWorldView, matProj);
+        CullMesh(matClip, vEyeObject);
+        PROFILE_LAP(profiler, STAGE_CULL);
+
+        // Whatever was worked out from an older matWorld or light is stale
+        if (memcmp(matWorld.m, matWorldBaked.m, sizeof(matWorld.m)) != 0) {
+            matWorldBaked = matWorld;
+            nShadeVersion++;
+        }
+        Vec3d vLight = Vector_Normalise(vLightDirection);
+        if (vLight.x != vLightBaked.x || vLight.y != vLightBaked.y || vLight.z != vLightBaked.z) {
+            vLightBaked = vLight;
+            nShadeVersion++;
+        }
+
+        nTrianglesShaded = BakeBlocks(pTriRanges, nTriRanges, vecShade.size(), vecShadeBaked, nShadeVersion,
+            [&](size_t nFirst, size_t nLast) { ShadeTriangles(nFirst, nLast); });
+        PROFILE_LAP(profiler, STAGE_LIGHTING);
+
+        // Transform each vertex once, rather than once per triangle that uses
+        // it, straight from the mesh's space into clip space
+        TransformVertices(matClip, vsObject, vsClip);
+        nVerticesTransformed = 0;
+        for (size_t r = 0; r < nVertRanges; r++)
+            nVerticesTransformed += pVertRanges[r].nLast - pVertRanges[r].nFirst;
+        PROFILE_LAP(profiler, STAGE_TRANSFORM);
+
+        vecOutcodes.resize(vsClip.size());
+        ForVertexRanges([&](size_t nFirst, size_t nLast) {
+            for (size_t i = nFirst; i < nLast; i++)
+                vecOutcodes[i] = Clip_Outcode(clipPlanes, CULL_PLANES, vsClip.Get(i));
+        });
+        PROFILE_LAP(profiler, STAGE_CLIP);
+
+        ProjectVertices();
+        PROFILE_LAP(profiler, STAGE_PROJECTION);
+
+        //Draw Triangles 
+        // Each run of triangles projects into its own part of one block, with
+        // room for the most it could fan out into
+        Triangle* pTris = arena.Alloc<Triangle>((size_t)nTrianglesInView * CLIP_MAX_FAN);
+        size_t nTris = 0;
+        nTrianglesClipped = 0;
+        if (bParallelGeometry) {
+            // Then the parts are closed up in order, giving exactly the serial order
+            int nChunks = (int)nTriRanges;
+            size_t* pChunkFirst = arena.Alloc<size_t>(nChunks);
+            size_t* pChunkCount = arena.Alloc<size_t>(nChunks);
+            int* pChunkClipped = arena.Alloc<int>(nChunks);
+            size_t nRoom = 0;
+            for (int n = 0; n < nChunks; n++) {
+                pChunkFirst[n] = nRoom;
+                nRoom += (pTriRanges[n].nLast - pTriRanges[n].nFirst) * CLIP_MAX_FAN;
+            }
+
+            Pool().ParallelFor(nChunks, [&](int n, int) {
+                pChunkClipped[n] = 0;
+                pChunkCount[n] = ProjectTriangles(pTriRanges[n].nFirst, pTriRanges[n].nLast, pTris + pChunkFirst[n], pChunkClipped[n], false);
+            });
+
+            for (int n = 0; n < nChunks; n++) {
+                nTrianglesClipped += pChunkClipped[n];
+                memmove(pTris + nTris, pTris + pChunkFirst[n], pChunkCount[n] * sizeof(Triangle));
+                nTris += pChunkCount[n];
+            }
+            PROFILE_LAP(profiler, STAGE_PROJECTION);
+        }
+        else {
+            for (size_t r = 0; r < nTriRanges; r++)
+                nTris += ProjectTriangles(pTriRanges[r].nFirst, pTriRanges[r].nLast, pTris + nTris, nTrianglesClipped, true);
+        }
+
+        // The depth buffer takes care of hidden surfaces in any order
+        if (!bDepthBuffer)
+            pTris = SortTriangles(pTris, nTris);
+        PROFILE_LAP(profiler, STAGE_SORT);
+
+        // Draw the transformed, clipped, projected, sorted triangles
+        nTrianglesDrawn = (int)nTris;
+        if (bTiledRaster)
+            RasterTiles(pTris, nTris);
+        else
+        {
+            for (size_t i = 0; i < nTris; i++)
+            {
+                const Triangle& t = pTris[i];
+                const CHAR_INFO* pDither = bDither ? Shade_Dither(t.shade) : nullptr;
+                if (bDepthBuffer)
+                    FillTriangleDepth(t.p[0].x, t.p[0].y, t.p[0].z, t.p[1].x, t.p[1].y, t.p[1].z, t.p[2].x, t.p[2].y, t.p[2].z, t.sym, t.col, 0, 0, ScreenWidth(), ScreenHeight(), pDither);
+                else if (bGuardBand || bDither)
+                    FillTriangleClipped(t.p[0].x, t.p[0].y, t.p[1].x, t.p[1].y, t.p[2].x, t.p[2].y, t.sym, t.col, 0, 0, ScreenWidth(), ScreenHeight(), pDither);
+                else
+                    FillTriangle(t.p[0].x, t.p[0].y, t.p[1].x, t.p[1].y, t.p[2].x, t.p[2].y, t.sym, t.col);
+                //DrawTriangle(t.p[0].x, t.p[0].y, t.p[1].x, t.p[1].y, t.p[2].x, t.p[2].y, PIXEL_SOLID, FG_BLACK);
+            }
+        }
+        PROFILE_LAP(profiler, STAGE_RASTER);
+
+#ifdef OLC_COUNT_ALLOCS
+        nFrameAllocs = Alloc_Count() - nAllocsBefore;
+        bArenaGrew = arena.Capacity() != nArenaBefore || arena.Overflowed();
+        assert(nSettledFrames < 2 || bArenaGrew || nFrameAllocs == 0);
+#endif
+        PROFILE_END_FRAME(profiler);
+        return true;
+    }
+};